@@ -0,0 +1,105 @@
+#pragma once
+#ifndef COMPRESSED_EVENT_STORE_H
+#define COMPRESSED_EVENT_STORE_H
+
+#include <cstdint>
+#include <vector>
+#include "EventColumns.h"
+
+/*
+    Compressed in-memory copy of a time sorted event set, an alternative resident format to EventColumns.
+
+    Events are cut into blocks of BLOCK_EVENTS, one per EventColumns chunk. Inside a block
+      - x and y are stored relative to the block minimum with just enough bits for the block's range,
+      - times are stored as deltas to the previous event, packed with the width that minimizes the block size; the few
+        deltas that do not fit (gaps in the recording) keep their high bits in an exception list,
+      - polarity stays one bit per event.
+    A dense recording ends up at about 3 bytes per event instead of the 8 of EventColumns.
+
+    Packed fields use a vertical layout: values are interleaved over 4 lanes of 32-bit words, so one 128-bit shift and
+    mask unpacks 4 values at once (SSE2, with a scalar fallback producing the same result). Readers decode batches of
+    blocks back into EventColumns, see EventData::forEachSegment.
+*/
+
+/**
+ * @brief Delta / bit-packed event blocks with a vectorized decoder.
+ */
+class CompressedEventStore {
+    public:
+        static const size_t BLOCK_EVENTS = EventColumns::CHUNK_EVENTS;
+        static const size_t LANES = 4;   // 32-bit values unpacked per SIMD step
+        static const size_t GROUP = 128; // values per packed group, 32 per lane
+
+        /**
+         * @brief Replaces the contents with events, encoding the blocks in parallel.
+         * @param events must start on a chunk, i.e. events.origin is a multiple of BLOCK_EVENTS
+         */
+        void assign(const EventColumnsView &events);
+
+        void clear();
+
+        bool empty() const { return eventCount == 0; }
+        size_t size() const { return eventCount; }
+        size_t getBlockCount() const { return blocks.size(); }
+
+        /**
+         * @brief Memory held by the encoded blocks, in bytes.
+         */
+        size_t getBytes() const;
+
+        static size_t blockOf(size_t eventIndex) { return eventIndex / BLOCK_EVENTS; }
+        static size_t blockStart(size_t block) { return block * BLOCK_EVENTS; }
+
+        /**
+         * @brief Decodes blocks [firstBlock, lastBlock) into out, in parallel, replacing its contents. Event
+         * blockStart(firstBlock) ends up at index 0 of out.
+         * @param firstBlock
+         * @param lastBlock exclusive
+         * @param out
+         */
+        void decode(size_t firstBlock, size_t lastBlock, EventColumns &out) const;
+
+        int64_t getTimestamp(size_t i) const;
+
+        /**
+         * @brief Index of the first event with a timestamp >= timestamp, size() if there is none.
+         */
+        size_t lowerBound(int64_t timestamp) const;
+
+        /**
+         * @brief Index of the first event with a timestamp > timestamp, size() if there is none.
+         */
+        size_t upperBound(int64_t timestamp) const;
+
+    private:
+        /**
+         * @brief One encoded block. words holds, in order: the packed x, y and time delta fields (GROUP aligned), the
+         * raw polarity words and the exceptions as (index, high bits) pairs.
+         */
+        struct Block {
+            int64_t firstTimestamp;
+            int64_t lastTimestamp;
+            uint32_t count;
+            uint16_t minX;
+            uint16_t minY;
+            uint8_t xBits;
+            uint8_t yBits;
+            uint8_t dtBits;
+            uint32_t exceptionCount;
+            std::vector<uint32_t> words;
+        };
+
+        static Block encodeBlock(const EventColumnsView &events);
+        static void decodeBlock(const Block &block, EventColumns &out, size_t at);
+
+        /**
+         * @brief Offsets from firstTimestamp of every event of the block, the time column alone.
+         */
+        static void decodeTimes(const Block &block, uint32_t *dt);
+
+        size_t eventCount = 0;
+        std::vector<Block> blocks;
+        std::vector<int64_t> blockLastT; // lastTimestamp of every block, binary searched first
+};
+
+#endif // COMPRESSED_EVENT_STORE_H
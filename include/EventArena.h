@@ -0,0 +1,74 @@
+#pragma once
+#ifndef EVENT_ARENA_H
+#define EVENT_ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+/*
+    Process wide arena for the large buffers event data lives in: the columns of EventColumns and drawFrame's scratch.
+
+    Requests of at least LARGE_BYTES are rounded up to whole 2 MB pages and mapped directly, backed by huge pages where
+    the OS gives them: on Windows VirtualAlloc with MEM_LARGE_PAGES if the account may lock pages in memory
+    (SeLockMemoryPrivilege), elsewhere mmap aligned to 2 MB plus madvise(MADV_HUGEPAGE) for transparent huge pages. A
+    scan over such a buffer then needs one TLB entry per 2 MB instead of per 4 KB.
+
+    Freed blocks are not unmapped but cached, up to cacheLimit_MB, and handed out again for a request they fit without
+    wasting more than half of them. A reset or reload thus gets back the pages the previous recording already faulted
+    in. Smaller requests go to operator new.
+*/
+
+/**
+ * @brief Huge page backed block allocator that keeps freed blocks for reuse.
+ */
+class EventArena {
+    public:
+        static const size_t HUGE_PAGE_BYTES = size_t(2) << 20;
+        static const size_t LARGE_BYTES = HUGE_PAGE_BYTES / 2; // smaller requests are not worth a mapping of their own
+
+        static inline int cacheLimit_MB = 1024; // freed blocks kept for reuse, at most
+
+        /**
+         * @brief Memory for bytes bytes, aligned to 2 MB if it is a large request.
+         * @throws std::bad_alloc if nothing could be mapped
+         */
+        static void *allocate(size_t bytes);
+
+        /**
+         * @brief Returns memory from allocate; bytes must be the size it was allocated with.
+         */
+        static void deallocate(void *ptr, size_t bytes);
+
+        /**
+         * @brief Unmaps every cached block.
+         */
+        static void trim();
+
+        /**
+         * @brief Bytes held in cached blocks, not counting those in use.
+         */
+        static size_t getCachedBytes();
+};
+
+/**
+ * @brief Standard allocator over EventArena, so std::vector can live in it.
+ */
+template <typename T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    ArenaAllocator() = default;
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &) noexcept {}
+
+    T *allocate(size_t n) { return static_cast<T *>(EventArena::allocate(n * sizeof(T))); }
+    void deallocate(T *ptr, size_t n) { EventArena::deallocate(ptr, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &) const { return true; }
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif // EVENT_ARENA_H
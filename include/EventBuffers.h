@@ -0,0 +1,67 @@
+#pragma once
+#ifndef EVENT_BUFFERS_H
+#define EVENT_BUFFERS_H
+
+#include <cstddef>
+#include <GL/glew.h>
+#include "EventColumns.h"
+#include "Program.h"
+
+/*
+    GPU copy of EventColumns for instanced drawing: one per instance VBO each for x (uint16), y (uint16) and the time
+    offset dt (uint32), plus the packed polarity bits and the int64 chunk bases in shader storage buffers that
+    phong_inst.vsh indexes with gl_InstanceID. The shader rebuilds the time of an event relative to a timeOrigin uniform
+    from its chunk base and offset, so no absolute timestamp ever goes through a float.
+*/
+
+/**
+ * @brief Owns the instancing buffers of one event set.
+ */
+class EventBuffers {
+    public:
+        EventBuffers() = default;
+        ~EventBuffers() { release(); }
+
+        EventBuffers(const EventBuffers &) = delete;
+        EventBuffers &operator=(const EventBuffers &) = delete;
+
+        /**
+         * @brief Writes events to instances [at, at + events.size()), growing the buffers geometrically (on the GPU,
+         * keeping the instances before at) if needed. Instances from at on that are not rewritten are dropped.
+         * @param events must start on a chunk, i.e. events.origin is a multiple of EventColumns::CHUNK_EVENTS
+         * @param at must be a multiple of EventColumns::CHUNK_EVENTS for the same reason
+         */
+        void upload(const EventColumnsView &events, size_t at);
+
+        /**
+         * @brief Replaces the contents with events.
+         */
+        void assign(const EventColumnsView &events);
+
+        void release();
+
+        /**
+         * @brief Makes room for at least events instances, keeping the current ones.
+         */
+        void reserve(size_t events);
+
+        size_t size() const { return count; }
+
+        /**
+         * @brief Sets up aInstX, aInstY, aInstDt and the polarity and chunk base buffers for a glDrawArraysInstanced call.
+         * @return false if the program does not have the instance attributes
+         */
+        bool bind(const Program &progInst) const;
+        void unbind(const Program &progInst) const;
+
+    private:
+        GLuint xVBO = 0;
+        GLuint yVBO = 0;
+        GLuint dtVBO = 0;
+        GLuint polaritySSBO = 0;
+        GLuint chunkBaseSSBO = 0;
+        size_t count = 0;
+        size_t capacity = 0;
+};
+
+#endif // EVENT_BUFFERS_H
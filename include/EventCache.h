@@ -0,0 +1,152 @@
+#pragma once
+#ifndef EVENT_CACHE_H
+#define EVENT_CACHE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <glm/glm.hpp>
+#include "MappedFile.h"
+#include "EventColumns.h"
+#include "LoadOptions.h"
+
+/*
+    Binary sidecar cache for decoded recordings, stored next to the .aedat4 as <recording>.novacache.
+
+    Layout is a fixed 128 byte header followed by the event columns (see EventColumnsLayout), i.e. exactly what
+    EventData keeps in memory. Reopening a recording then only needs a header check and a file mapping, no decode and
+    no per-event conversion.
+
+    The source checksum is sampled (size, modification time and a few evenly spaced chunks of the file) rather than a
+    full hash, otherwise validating a multi-GB cache would cost about as much IO as decoding it.
+*/
+
+/**
+ * @brief On-disk header of a .novacache file. Bump EventCache::VERSION whenever this or the payload layout changes.
+ */
+struct EventCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint64_t sourceChecksum;
+    uint64_t eventCount;
+    int64_t earliestTimestamp;
+    int64_t latestTimestamp;
+    float diffScale;
+    float cameraWidth;
+    float cameraHeight;
+    float minXYZ[3];
+    float maxXYZ[3];
+
+    // LoadOptions the events were selected with
+    int32_t decimationType;
+    uint32_t modFreq;
+    uint32_t packetStride;
+    float keep_ms;
+    float period_ms;
+    int32_t polarity;
+    uint16_t roi[4]; // min x, min y, max x, max y
+    uint8_t roiEnabled;
+
+    uint8_t reserved[11];
+};
+static_assert(sizeof(EventCacheHeader) == 128, "EventCacheHeader must stay 128 bytes so the payload is 16 byte aligned");
+
+/**
+ * @brief Read side of the cache: validates and maps a .novacache file.
+ */
+class EventCache {
+    public:
+        static constexpr uint32_t VERSION = 5;
+        static constexpr char MAGIC[8] = {'N', 'O', 'V', 'A', 'E', 'V', 'T', 'C'};
+
+        /**
+         * @brief Path of the cache belonging to a recording.
+         * @param recording path to the .aedat4 file
+         */
+        static std::string cachePathFor(const std::string &recording);
+
+        /**
+         * @brief Sampled 64-bit FNV-1a checksum of the recording, see the file comment for what is covered.
+         * @param recording
+         * @return 0 if the file cannot be read
+         */
+        static uint64_t sourceChecksum(const std::string &recording);
+
+        /**
+         * @brief Maps the cache of the recording if it exists and matches the version, load options and source checksum.
+         * @param recording path to the .aedat4 file
+         * @param options load options the cache must have been written with
+         * @return true if the cache is valid and mapped
+         */
+        bool open(const std::string &recording, const LoadOptions &options);
+
+        /**
+         * @brief Stores options in the header fields that key the cache.
+         */
+        static void setOptions(EventCacheHeader &header, const LoadOptions &options);
+
+        /**
+         * @brief Reads back the options a header was written with.
+         */
+        static LoadOptions getOptions(const EventCacheHeader &header);
+        void close() { mapping.close(); }
+
+        bool isOpen() const { return mapping.isOpen(); }
+        const EventCacheHeader &getHeader() const { return *reinterpret_cast<const EventCacheHeader *>(mapping.data()); }
+        EventColumnsView getEvents() const;
+
+    private:
+        MappedFile mapping;
+};
+
+/**
+ * @brief Write side of the cache: events are appended as they are decoded, the header is finalized last. The file is
+ * written under a temporary name and only renamed into place by finish(), so a cancelled load never leaves a cache
+ * that looks valid. The event count is unknown until then, so y, dt, polarity and the chunk bases go to temporary
+ * column files first and are concatenated behind x by finish().
+ */
+class EventCacheWriter {
+    public:
+        EventCacheWriter() = default;
+        ~EventCacheWriter() { abort(); }
+
+        EventCacheWriter(const EventCacheWriter &) = delete;
+        EventCacheWriter &operator=(const EventCacheWriter &) = delete;
+
+        /**
+         * @brief Creates the temporary cache file and reserves room for the header.
+         * @param recording path to the .aedat4 file
+         * @return false if the file could not be created; appends are then no-ops
+         */
+        bool begin(const std::string &recording);
+
+        void append(const EventColumnsView &events);
+
+        /**
+         * @brief Writes the final header and renames the file into place.
+         * @param header everything except magic, version and eventCount, which are filled in here
+         */
+        void finish(EventCacheHeader header);
+
+        /**
+         * @brief Closes and deletes the temporary file, if any.
+         */
+        void abort();
+
+        bool isOpen() const { return file != nullptr; }
+
+    private:
+        std::FILE *file = nullptr; // header and x
+        std::FILE *yFile = nullptr;
+        std::FILE *dtFile = nullptr;
+        std::FILE *polarityFile = nullptr;
+        std::FILE *chunkFile = nullptr;
+        std::string tmpPath;
+        std::string finalPath;
+        uint64_t eventCount = 0;
+        uint64_t polarityWord = 0; // bits of the events past the last full word written to polarityFile
+        int64_t chunkBase = 0;     // base of the chunk the next event falls into, unless it starts a new one
+};
+
+#endif // EVENT_CACHE_H
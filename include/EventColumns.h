@@ -0,0 +1,147 @@
+#pragma once
+#ifndef EVENT_COLUMNS_H
+#define EVENT_COLUMNS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+#include "EventArena.h"
+
+/*
+    Structure of arrays event storage: uint16 x and y, a uint32 time offset and one polarity bit per event, i.e. 8.125
+    bytes per event instead of the 16 of a glm::vec4. Loops only pull in the columns they read, so e.g. time searches
+    touch nothing but the time columns.
+
+    Timestamps are kept exact. Every CHUNK_EVENTS consecutive events share an int64 base timestamp (microseconds, as in
+    the recording) and each event stores its microsecond offset dt from that base; a float of the scaled time since the
+    start of the recording only has 24 bits, which merges neighbouring microseconds after about 16.7 s. Offsets are
+    small, so they also go to the GPU as exact floats (see EventBuffers.h).
+
+    Polarity is packed little endian into 64-bit words (bit i of the column is bit i % 64 of word i / 64).
+
+    The columns are allocated from EventArena, i.e. huge page backed and reused across reloads.
+*/
+
+/**
+ * @brief Byte offsets of the columns of n events stored back to back from some base offset, the on-disk layout shared
+ * by EventCache and PagedEventStore: x[n] | y[n] | dt[n] | polarity words[(n + 63) / 64] | chunk bases.
+ */
+struct EventColumnsLayout {
+    uint64_t x;
+    uint64_t y;
+    uint64_t dt;
+    uint64_t polarity;
+    uint64_t chunkBase;
+    uint64_t end;
+
+    static EventColumnsLayout of(uint64_t events, uint64_t base);
+};
+
+/**
+ * @brief Non-owning view over event columns; what every reader of EventData goes through.
+ */
+struct EventColumnsView {
+    std::span<const uint16_t> x;
+    std::span<const uint16_t> y;
+    std::span<const uint32_t> dt; // microseconds since the base of the event's chunk
+    const uint64_t *polarityBits = nullptr;
+    const int64_t *chunkBase = nullptr;
+    size_t origin = 0; // index of this view's first event within the columns polarityBits and chunkBase belong to
+
+    size_t size() const { return dt.size(); }
+    bool empty() const { return dt.empty(); }
+
+    float getPolarity(size_t i) const {
+        size_t bit = origin + i;
+        return static_cast<float>((polarityBits[bit >> 6] >> (bit & 63)) & 1);
+    }
+
+    int64_t getTimestamp(size_t i) const;
+
+    /**
+     * @brief Index of the first event with a timestamp >= timestamp, size() if there is none.
+     */
+    size_t lowerBound(int64_t timestamp) const;
+
+    /**
+     * @brief Index of the first event with a timestamp > timestamp, size() if there is none.
+     */
+    size_t upperBound(int64_t timestamp) const;
+
+    /**
+     * @brief Events [first, first + count).
+     */
+    EventColumnsView subview(size_t first, size_t count) const {
+        return { x.subspan(first, count), y.subspan(first, count), dt.subspan(first, count), polarityBits, chunkBase, origin + first };
+    }
+};
+
+/**
+ * @brief Growable owner of event columns.
+ */
+class EventColumns {
+    public:
+        static const size_t CHUNK_EVENTS = 1 << 12; // events per time base, a multiple of 64
+        static size_t wordsFor(size_t events) { return (events + 63) / 64; }
+        static size_t chunksFor(size_t events) { return (events + CHUNK_EVENTS - 1) / CHUNK_EVENTS; }
+
+        size_t size() const { return dt.size(); }
+        bool empty() const { return dt.empty(); }
+        size_t capacity() const { return dt.capacity(); }
+
+        void reserve(size_t events);
+
+        /**
+         * @brief Empties the store and sizes it for events about to be appended. The current allocation is reused if it
+         * fits them without wasting more than half of it, otherwise it is released and exactly events are reserved.
+         */
+        void presize(size_t events);
+        void resize(size_t events);
+        void clear();
+
+        /**
+         * @brief Releases the memory as well, clear() keeps the capacity.
+         */
+        void release();
+
+        /**
+         * @brief Appends one event; timestamps must not decrease.
+         */
+        void push_back(uint16_t evtX, uint16_t evtY, int64_t timestamp, bool polarity) {
+            if ((size() & 63) == 0) {
+                polarityBits.push_back(0);
+            }
+            if (size() % CHUNK_EVENTS == 0) {
+                chunkBase.push_back(timestamp);
+            }
+            polarityBits.back() |= static_cast<uint64_t>(polarity) << (size() & 63);
+            x.push_back(evtX);
+            y.push_back(evtY);
+
+            // Only a chunk spanning over 71 minutes could overflow, saturate rather than wrap
+            dt.push_back(static_cast<uint32_t>(std::min<int64_t>(timestamp - chunkBase.back(), UINT32_MAX)));
+        }
+
+        /**
+         * @brief Appends every event of other, rebasing its times and realigning its polarity bits as needed.
+         * @param other
+         */
+        void append(const EventColumnsView &other);
+
+        void swap(EventColumns &other) noexcept;
+
+        EventColumnsView view() const { return { x, y, dt, polarityBits.data(), chunkBase.data(), 0 }; }
+        operator EventColumnsView() const { return view(); }
+
+        // Raw columns, e.g. for reading straight into them; polarityBits holds wordsFor(size()) words and chunkBase
+        // chunksFor(size()) bases
+        ArenaVector<uint16_t> x;
+        ArenaVector<uint16_t> y;
+        ArenaVector<uint32_t> dt;
+        ArenaVector<uint64_t> polarityBits;
+        ArenaVector<int64_t> chunkBase;
+};
+
+#endif // EVENT_COLUMNS_H
@@ -4,12 +4,28 @@
 
 #include <vector>
 #include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <span>
+#include <memory>
 #include <glm/glm.hpp>
 #include "MatrixStack.h"
 #include "Program.h"
 #include "BPMaterial.h"
 #include "Mesh.h"
+#include "EventCache.h"
+#include "LoadOptions.h"
+#include "VoxelGrid.h"
+#include "PixelPrefix.h"
+#include "PagedEventStore.h"
+#include "CompressedEventStore.h"
+#include "EventColumns.h"
+#include "EventBuffers.h"
+#include "LiveEventRing.h"
+#include "EventExporter.h"
 #include <dv-processing/io/mono_camera_recording.hpp>
+#include <dv-processing/io/network_reader.hpp>
 
 /*
     We can treat the data processed from dv-processing as particles in 3D space
@@ -17,7 +33,9 @@
     coordinate is the timestamp.
 
     Because timestamp is an int64_t, we should acknowledge possible truncation when
-    converting to float.
+    converting to float. Events therefore keep their exact timestamps (see EventColumns.h);
+    only values shown in the GUI, such as the time windows, are scaled floats, and they are
+    turned back into timestamps before any lookup.
 */
 
 /**
@@ -34,10 +52,9 @@ class EventData {
         void reset();
         
         /**
-         * @brief Initializes instancing (https://learnopengl.com/Advanced-OpenGL/Instancing) for the event particles using the provided shader program.
-         * @param progInst
+         * @brief Initializes instancing (https://learnopengl.com/Advanced-OpenGL/Instancing) for the event particles.
          */
-        void initInstancing(Program &instancingProg);
+        void initInstancing();
         
         /**
          * @brief Initializes the particles from a file. The file should be in the format of aedat4.
@@ -45,6 +62,98 @@ class EventData {
          */
         void initParticlesFromFile(const std::string &filename);
 
+        /**
+         * @brief Starts decoding an aedat4 file on a worker thread so the render loop is never blocked. Decoded batches are
+         * staged by the worker and only become visible once streamPendingEvents() is called from the render thread.
+         * If a valid .novacache exists next to the file it is mapped instead and no worker is started.
+         * @param filename 
+         */
+        void startStreamingFromFile(const std::string &filename);
+
+        /**
+         * @brief Moves batches staged by the loader thread into the event store and appends them to the instancing VBO.
+         * Must be called from the thread owning the GL context, once per frame while loading.
+         * @return true if new events were appended this call
+         */
+        bool streamPendingEvents();
+
+        /**
+         * @brief Asks the loader thread to stop after its current batch and waits for it. Events streamed so far are kept.
+         */
+        void cancelLoading();
+
+        /**
+         * @brief Rebuilds the voxel grid downsampled set and its VBO if voxelOptions or the loaded events changed. Skipped
+         * while a file is still streaming in, so the grid is built once over the complete recording.
+         * @return true if the set drawn by drawInstanced() / drawFrame() changed
+         */
+        bool updateDownsampling();
+
+        /**
+         * @brief Rebuilds the per pixel prefix sums drawFrame() answers box shutter accumulation images from, if
+         * usePixelPrefix, its budget or the loaded events changed. Same restrictions as updateDownsampling().
+         * @return true if the prefix sums were built or dropped
+         */
+        bool updatePixelPrefix();
+
+        /**
+         * @brief Switches the loaded events between EventColumns and CompressedEventStore when compressResident changed.
+         * Skipped while a file is still streaming in and for paged recordings.
+         * @return true if the resident format changed
+         */
+        bool updateCompression();
+
+        /**
+         * @brief Applies a changed event decimation factor (loadOptions.modFreq) to the loaded recording without a reload:
+         * the shown events are rebuilt in parallel from the full resolution ones, which the event cache keeps. Skipped
+         * while a file is still streaming in, for paged recordings and if no full resolution events are at hand.
+         * @return true if the shown events changed
+         */
+        bool updateDecimation();
+
+        /**
+         * @brief Writes the selected events to path: those of the event window that lie in the space window and, with
+         * isPositiveOnly, have positive polarity. Reads resident, compressed and paged recordings alike, see
+         * EventExporter.h for the formats.
+         * @param path
+         * @param format
+         * @return false if nothing is selected or the file could not be written; the reason is printed
+         */
+        bool exportSelection(const std::string &path, EventExporter::Format format);
+
+        /**
+         * @brief Connects to a dv-processing network event stream (a camera served by DV, or `NOVA --replay`) and shows
+         * its newest events instead of a file. Events are ingested on their own thread into liveIngest->ring.
+         * @param host 
+         * @param port 
+         * @return false if the connection failed
+         */
+        bool startLiveStream(const std::string &host, int port);
+
+        /**
+         * @brief Stops ingesting without waiting for the ingest thread, the events received so far are kept.
+         */
+        void stopLiveStream();
+
+        /**
+         * @brief Moves events ingested since the last call into the event store and slides the time base so the 3D view
+         * and the DCE windows follow the newest liveWindow_ms. Must be called from the thread owning the GL context, once
+         * per frame.
+         * @return true if new events arrived
+         */
+        bool updateLiveWindow();
+
+        /**
+         * @brief Playlist playback: takes over the display settings of previous and continues its DCE windows in this
+         * recording, one frame period on. Window and shutter spans are kept in microseconds, or in events when stepping
+         * by events. See Session.h.
+         * @param previous recording played before this one
+         * @param byEvents whether playback steps by events or by time
+         * @param framePeriod_T time step, in normalized time of previous
+         * @param framePeriod_E event step
+         */
+        void continueFrom(const EventData &previous, bool byEvents, float framePeriod_T, uint framePeriod_E);
+
         /**
          * @brief Initializes the EventData object in an empty state; upon initialization, no particles are loaded.
          */
@@ -87,13 +196,15 @@ class EventData {
         /**
          * @brief Computes the weight of valid events (within shutter) and passes them into the vertex to render DCE
          * @param prog bound to access the associated shaders and uniforms
+         * @param progImage draws the accumulation image
          * @param viewport_resolution used to compute needed point size
          * @param morlet specifies the contribution function to be used
          * @param freq used to calculate morlet shutter contribution if needed
          * @param pca specifies whether pca is computed and displayed
+         * @param accumulationImage accumulate into one sensor sized texture instead of drawing a point per event
          */
-        void drawFrame(Program &prog, glm::vec2 viewport_resolution, 
-            bool morlet, float freq, bool pca);
+        void drawFrame(Program &prog, Program &progImage, glm::vec2 viewport_resolution, 
+            bool morlet, float freq, bool pca, bool accumulationImage);
 
         /**
          * @brief Used by utils/drawGUI to allow for changing back into time from specified unit of time
@@ -132,7 +243,16 @@ class EventData {
         const glm::vec3 getMax_XYZ() const { return maxXYZ; }
         const float &getMaxTimestamp() const { return maxXYZ.z; }
         const float &getMinTimestamp() const { return minXYZ.z; }
-        const uint getMaxEvent() const { return static_cast<const uint>(evtParticles.size()); }
+        const uint getMaxEvent() const { return static_cast<const uint>(numEvents()); }
+        bool isLoading() const { return loading; }
+        bool isLoadComplete() const { return !loading && !loaderThread.joinable(); } // every batch has been streamed in
+        bool isPaged() const { return pagedStore.isOpen(); }
+        bool isCompressed() const { return !compressedStore.empty(); }
+        bool isLive() const { return live; }
+        bool isLiveConnected() const { return liveIngest && liveIngest->connected; }
+        size_t getCompressedBytes() const { return compressedStore.getBytes(); }
+        float getLoadProgress() const { return loadProgress; }
+        const std::string &getFilename() const { return loadingFilename; } // last file loaded, empty if none
         
         float &getTimeWindow_L() { return timeWindow_L; }
         float &getTimeWindow_R() { return timeWindow_R; }
@@ -153,14 +273,145 @@ class EventData {
         static inline int TIME_CONVERSION; 
         static const int TIME_SHUTTER = 0; // values must match ImGui::Combo order in utils.cpp
         static const int EVENT_SHUTTER = 1;
-        static inline uint modFreq = 1; // only draw the modFreq'th particle of the ones we read in
+        static inline LoadOptions loadOptions; // decimation applied by the next load, see LoadOptions.h
+        static inline bool useEventCache = true; // read / write <recording>.novacache, see EventCache.h
+        static inline VoxelGridOptions voxelOptions; // display time downsampling, see VoxelGrid.h
+        static inline bool usePixelPrefix = false; // box shutter accumulation images from per pixel prefix sums, see PixelPrefix.h
+        static inline int pixelPrefixBudget_MB = 512; // memory the prefix sums' checkpoints may take
+        static inline bool incrementalFrames = true; // box shutter accumulation images only count the events entering / leaving the shutter
+        static inline int residentBudget_MB = 4096; // recordings larger than this are paged from their .novacache, see PagedEventStore.h
+        static inline bool compressResident = false; // keep loaded events delta / bit-packed in RAM, see CompressedEventStore.h
+        static inline float liveWindow_ms = 1000.0f; // time span shown while live
+        static inline int liveRingEvents = 1 << 22; // newest events kept by the live ingest, see LiveEventRing.h
     private:
+        /**
+         * @brief Body of the loader thread: decodes the recording in parallel time slices and stages them, in order, for
+         * streamPendingEvents().
+         * @param reader already opened recording, reused by the first decode thread
+         * @param filename used to open one additional reader per decode thread
+         * @param options snapshot of loadOptions, so GUI edits during the load cannot race with the worker
+         */
+        void streamWorker(std::unique_ptr<dv::io::MonoCameraRecording> reader, std::string filename, LoadOptions options);
+
+        /**
+         * @brief Body of the loader thread for files read by EventImporter: decodes the whole file, writes its cache and
+         * stages everything at once, together with the time span and sensor size only known after decoding.
+         * @param filename
+         * @param options snapshot of loadOptions
+         */
+        void importWorker(std::string filename, LoadOptions options);
+
+        // State shared with the live ingest thread, which keeps it (and its reader) alive on its own until it exits
+        struct LiveIngest {
+            LiveEventRing ring;
+            std::atomic<bool> stopRequested{false};
+            std::atomic<bool> connected{true};
+        };
+
+        /**
+         * @brief Body of the detached live ingest thread: pushes every received event batch into ingest->ring until
+         * stopped or disconnected.
+         * @param ingest
+         * @param reader connected network stream
+         */
+        static void liveWorker(std::shared_ptr<LiveIngest> ingest, std::unique_ptr<dv::io::NetworkReader> reader);
+
+        /**
+         * @brief Maps the event cache of filename into the event store if it is valid.
+         * @param filename 
+         * @return true on a cache hit, in which case loading is already complete
+         */
+        bool loadFromCache(const std::string &filename, const LoadOptions &options);
+
+        /**
+         * @brief Number of loaded events, whether they are in memory or paged.
+         */
+        size_t numEvents() const {
+            return pagedStore.isOpen() ? pagedStore.size() : !compressedStore.empty() ? compressedStore.size() : evtView.size();
+        }
+
+        /**
+         * @brief Inverse of the scaled time: microseconds since earliestTimestamp, not rounded.
+         * @param scaled time as shown in the GUI, in normalized units
+         */
+        double toElapsedUs(float scaled) const { return static_cast<double>(scaled) / diffScale; }
+
+        /**
+         * @brief Calls fn(events, firstIndex) on consecutive views covering events [first, last]. In memory that is a
+         * single view; when paged, one view per block, each block only resident while fn runs; when compressed, one view
+         * per batch of DECODE_BATCH_BLOCKS blocks decoded into decodeScratch.
+         * @param first 
+         * @param last inclusive
+         * @param fn 
+         */
+        template <typename Fn>
+        void forEachSegment(size_t first, size_t last, Fn &&fn) const;
+
+        /**
+         * @brief Sets framePositive / frameNegative to the per pixel counts of events [first, last], from the prefix
+         * sums or, if the previous shutter overlaps enough, by adding and removing only the events that differ.
+         * @param first
+         * @param last inclusive, empty if before first
+         * @param fromPrefix
+         */
+        void countShutter(int first, int last, bool fromPrefix);
+
+        /**
+         * @brief Paged mode only: refills the instancing VBO with the blocks around the current event window.
+         */
+        void updatePagedInstancing();
+
+        /**
+         * @brief Moves staged events into evtParticles and merges their bounding box. Does not touch the GPU.
+         * @return index of the first newly added event
+         */
+        size_t mergePendingEvents();
+
+        /**
+         * @brief Joins the finished loader and, if it stopped staging at the resident budget, switches to paging from
+         * the completed cache. Shared by the streamed and the blocking load.
+         * @return true if the event store was replaced by the paged one
+         */
+        bool finishLoading();
+
+        /**
+         * @brief Drops the voxel grid and prefix sums built over evtView, for when the events leave it (compressed or
+         * paged); they are rebuilt once the events are resident again.
+         */
+        void releaseResidentStructures();
+
+        /**
+         * @brief Whether the voxel grid stands in for the events, which needs them resident.
+         */
+        bool isVoxelGridActive() const {
+            return voxelOptions.enabled && !voxelGrid.isEmpty() && compressedStore.empty() && !pagedStore.isOpen();
+        }
+
+        /**
+         * @brief Uploads evtView[first, size()) to the instancing buffers, growing them on the GPU if needed.
+         * @param first 
+         */
+        void appendInstancing(size_t first);
+
         glm::vec2 camera_resolution;
         float diffScale;
 
-        // TODO: Might be better to just store a std::bitset for polarity, and something dynamic like a color
-        // indicator for a (although we would need a vec3 for a full RGB)
-        std::vector<glm::vec4> evtParticles; // x, y, t, polarity (false=0.0, true=1.0)
+        // x, y, time columns and a polarity bitset, see EventColumns.h
+        // TODO: something dynamic like a color indicator per event (although we would need a vec3 for a full RGB)
+        EventColumns evtParticles;
+
+        // What every reader goes through: either evtParticles or the events of the mapped evtCache
+        EventColumnsView evtView;
+        EventCache evtCache;
+
+        // Used instead of evtView when the recording exceeds residentBudget_MB
+        PagedEventStore pagedStore;
+        size_t instFirstBlock; // block range currently in instBuffers while paged
+        size_t instLastBlock;
+
+        // Used instead of evtView when compressResident is set; instBuffers keep the uncompressed copy on the GPU
+        CompressedEventStore compressedStore;
+        mutable EventColumns decodeScratch; // render thread only, see forEachSegment
 
         long long earliestTimestamp;
         long long latestTimestamp;
@@ -185,7 +436,65 @@ class EventData {
         glm::vec3 center;
 
         // Instancing
-        GLuint instVBO;
+        EventBuffers instBuffers;
+        size_t instBase; // instances before this one are not drawn, see updateLiveWindow
+
+        // Voxel grid downsampling, built from evtView with voxelBuiltOptions over voxelBuiltCount events
+        VoxelGrid voxelGrid;
+        EventBuffers voxelBuffers;
+        VoxelGridOptions voxelBuiltOptions;
+        size_t voxelBuiltCount;
+
+        // Per pixel prefix sums, built from evtView over pixelPrefixBuiltCount events within pixelPrefixBuiltBudget_MB
+        PixelPrefix pixelPrefix;
+        size_t pixelPrefixBuiltCount;
+        int pixelPrefixBuiltBudget_MB;
+
+        // drawFrame scratch, kept across frames so they do not allocate and fault in their buffers anew, see EventArena.h
+        ArenaVector<float> frameTotal;
+        std::vector<ArenaVector<float>> frameThreadTotals;
+        std::vector<ArenaVector<float>> frameThreadImages; // accumulation image of every thread, folded into the first
+        ArenaVector<uint32_t> framePositive; // per pixel counts of events [frameCounts_L, frameCounts_R], see countShutter
+        ArenaVector<uint32_t> frameNegative;
+        size_t frameCountsEvents; // numEvents() the counts were taken at, 0 if they are stale
+        int frameCounts_L;
+        int frameCounts_R;
+
+        // Background loading; apart from the scale fixed before it starts, the worker only touches pending* (under pendingMutex)
+        // and the atomics below
+        std::thread loaderThread;
+        std::mutex pendingMutex;
+        std::vector<EventColumns> pendingBatches; // converted slices in time order, moved in whole rather than copied
+        glm::vec3 pendingMinXYZ;
+        glm::vec3 pendingMaxXYZ;
+        std::atomic<bool> loading;
+        std::atomic<bool> overflowToPaged; // staging stopped at the resident budget, switch to pagedStore once the cache is done
+        std::string loadingFilename;
+        LoadOptions loadingOptions;
+        std::atomic<bool> cancelRequested;
+        std::atomic<float> loadProgress;
+        std::atomic<size_t> presizeEvents; // events the load is expected to keep, 0 if unknown or already applied
+
+        /**
+         * @brief Time span and sensor size of an import, applied by the render thread with its events.
+         */
+        struct PendingTimeBase {
+            bool set = false;
+            long long earliestTimestamp = 0;
+            long long latestTimestamp = 0;
+            glm::vec2 resolution{0.0f};
+        };
+        PendingTimeBase pendingTimeBase; // under pendingMutex
+
+        // Event decimation in memory, see updateDecimation
+        EventColumns fullParticles; // full resolution events of a load without cache, kept once decimated
+        uint32_t shownModFreq; // factor the shown events were decimated with
+        uint32_t requestedModFreq; // last factor updateDecimation() acted on
+
+        // Live mode; the ingest thread only touches liveIngest, as the producer of its ring
+        std::shared_ptr<LiveIngest> liveIngest;
+        bool live;
+        uint64_t liveNext; // first ring event not yet moved into evtParticles
 
         glm::vec3 negColor;
         glm::vec3 posColor;
@@ -0,0 +1,109 @@
+#pragma once
+#ifndef EVENT_EXPORTER_H
+#define EVENT_EXPORTER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <glm/glm.hpp>
+#include "EventColumns.h"
+#include "EventSort.h"
+#include "MappedFile.h"
+#include <dv-processing/io/mono_camera_writer.hpp>
+
+/*
+    Writes a subset of the loaded events to a file for offline processing, in one of:
+      - raw binary (.bin): the events back to back as TimedEvent records (int64 timestamp in microseconds, uint16 x,
+        uint16 y, uint32 polarity; 16 bytes, little endian) with no header,
+      - NumPy (.npy): the same records as a 1-D structured array with fields t, x, y and p,
+      - AEDAT4 (.aedat4): through dv-processing's MonoCameraWriter, readable by everything that loads recordings.
+
+    Binary and NumPy files are sized exactly up front from a counting pass (see count) and memory mapped. Each appended
+    span is then filtered in parallel: threads count the events they keep in their slice, and after a prefix over the
+    slices write them straight to their final offset in the mapping, so nothing is staged in memory and the OS writes
+    the pages back at disk speed. AEDAT4 goes through the same filter into one dv::EventStore per span.
+*/
+
+/**
+ * @brief Space and polarity part of an export selection; the time part is the span of events passed in.
+ */
+struct ExportFilter {
+    uint16_t minX = 0;
+    uint16_t minY = 0;
+    uint16_t maxX = UINT16_MAX;
+    uint16_t maxY = UINT16_MAX;
+    bool positiveOnly = false;
+
+    bool keeps(uint16_t x, uint16_t y, bool positive) const {
+        return (positive || !positiveOnly) && minX <= x && x <= maxX && minY <= y && y <= maxY;
+    }
+};
+
+/**
+ * @brief Streams filtered event spans into a binary, NumPy or AEDAT4 file. The file is deleted again unless finish()
+ * succeeds.
+ */
+class EventExporter {
+    public:
+        enum Format { FORMAT_BINARY, FORMAT_NPY, FORMAT_AEDAT4 };
+
+        EventExporter() = default;
+        ~EventExporter();
+
+        EventExporter(const EventExporter &) = delete;
+        EventExporter &operator=(const EventExporter &) = delete;
+
+        /**
+         * @brief File extension of format, with the leading dot.
+         */
+        static const char *extensionOf(Format format);
+
+        /**
+         * @brief Number of events of events that filter keeps, counted in parallel.
+         */
+        static uint64_t count(const EventColumnsView &events, const ExportFilter &filter);
+
+        /**
+         * @brief Creates the output file.
+         * @param path
+         * @param format
+         * @param filter applied to every append
+         * @param events exact number of events the appends will keep, see count; sizes binary and NumPy files
+         * @param resolution sensor size, stored in AEDAT4 files
+         * @return false if the file could not be created or events is 0; the reason is printed
+         */
+        bool begin(const std::string &path, Format format, const ExportFilter &filter, uint64_t events, glm::vec2 resolution);
+
+        /**
+         * @brief Writes the events of events the filter keeps, which must follow those of the previous append in time.
+         * @return false once more events arrive than begin was told about, or the writer failed
+         */
+        bool append(const EventColumnsView &events);
+
+        /**
+         * @brief Flushes and closes the file.
+         * @return false, and the file is deleted, if fewer events were appended than announced or writing failed
+         */
+        bool finish();
+
+        /**
+         * @brief Closes and deletes the file, if any.
+         */
+        void abort();
+
+        bool isOpen() const { return output.isOpen() || writer != nullptr; }
+
+    private:
+        std::string path;
+        Format format = FORMAT_BINARY;
+        ExportFilter filter;
+
+        MappedFile output; // binary and NumPy
+        TimedEvent *records = nullptr;
+        uint64_t capacity = 0;
+        uint64_t written = 0;
+
+        std::unique_ptr<dv::io::MonoCameraWriter> writer; // AEDAT4
+};
+
+#endif // EVENT_EXPORTER_H
@@ -0,0 +1,59 @@
+#pragma once
+#ifndef EVENT_IMPORTER_H
+#define EVENT_IMPORTER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <glm/glm.hpp>
+#include "EventColumns.h"
+
+/*
+    Native readers for event files that are not .aedat4, so data from other sensors loads without converting it first:
+      - Prophesee raw streams (.raw) in EVT 2.0 (32-bit words) or EVT 3.0 (16-bit words), after their % header,
+      - text dumps (.csv, .txt) with one event per line, fields separated by commas, semicolons, spaces or tabs. A
+        header line naming the columns (t / ts / timestamp, x, y, p / pol / polarity) is optional; without one the
+        timestamp is the column with a decimal point, or else the largest value on the last line, and the others are
+        x, y, p in order. Timestamps written with a decimal point are seconds, otherwise microseconds.
+
+    Files are memory mapped and cut into ranges that are decoded in parallel, in two passes: the first only counts the
+    events of every range (and, for EVT, the decoder state each range leaves behind), the second writes every event
+    straight into its final slot of an EventColumns sized exactly once. Newline search and EVT 2.0 event counting
+    compare 16 bytes at a time with SSE2 where available. Files that turn out not to be in time order are decoded once
+    more and sorted, see EventSort.h.
+*/
+
+/**
+ * @brief Events of an imported file plus what the loader needs to place them.
+ */
+struct ImportedEvents {
+    EventColumns events;
+    int64_t earliestTimestamp = 0;
+    int64_t latestTimestamp = 0;
+    glm::vec2 resolution{0.0f}; // from the file header if it has one, else the extent of the events
+    glm::vec2 minXY{0.0f};
+    glm::vec2 maxXY{0.0f};
+};
+
+/**
+ * @brief Multi-threaded importers for EVT 2.0 / 3.0 raw files and CSV event dumps.
+ */
+class EventImporter {
+    public:
+        /**
+         * @brief Whether path has one of the extensions handled here.
+         */
+        static bool canImport(const std::string &path);
+
+        /**
+         * @brief Decodes the whole file into out, in time order.
+         * @param path
+         * @param modFreq keep every modFreq'th event, counted over the whole file
+         * @param cancel checked between the passes
+         * @param out
+         * @return false if the file cannot be read, is malformed or holds no events; the reason is printed
+         */
+        static bool import(const std::string &path, uint32_t modFreq, const std::atomic<bool> &cancel, ImportedEvents &out);
+};
+
+#endif // EVENT_IMPORTER_H
@@ -0,0 +1,50 @@
+#pragma once
+#ifndef EVENT_SORT_H
+#define EVENT_SORT_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "EventColumns.h"
+
+/*
+    Time ordering for event sources that do not guarantee it, e.g. CSV dumps merged from several sensors or packets
+    written out of order. Everything downstream (EventColumns' chunk offsets, the window searches, the voxel grid)
+    needs time sorted events, so the loaders check the order while decoding, which costs one compare per event, and
+    only go through here when it is broken.
+
+    Events are sorted unpacked, with their full timestamps, by a parallel LSD radix sort on the timestamp: 8 bits per
+    pass and only as many passes as the time span needs (4 for up to ~71 minutes). It is stable, so events sharing a
+    timestamp keep their order from the file.
+*/
+
+/**
+ * @brief One event with its full timestamp, the form events are sorted in.
+ */
+struct TimedEvent {
+    int64_t timestamp;
+    uint16_t x;
+    uint16_t y;
+    uint32_t polarity;
+};
+
+/**
+ * @brief Parallel sort of events by timestamp and conversion of the result to columns.
+ */
+class EventSort {
+    public:
+        /**
+         * @brief Stable sort by timestamp, in parallel.
+         * @param events
+         */
+        static void sortByTime(std::vector<TimedEvent> &events);
+
+        /**
+         * @brief Replaces out with the time sorted events, one parallel task per chunk.
+         * @param events
+         * @param out
+         */
+        static void toColumns(std::span<const TimedEvent> events, EventColumns &out);
+};
+
+#endif // EVENT_SORT_H
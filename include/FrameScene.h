@@ -14,7 +14,7 @@
 class FrameViewportFBO : public BaseViewportFBO {
 public:
     FrameViewportFBO() : BaseViewportFBO::BaseViewportFBO(), morlet(false), pca(false),
-        autoUpdate(false), freq(0.01f), fps(0.0f), 
+        accumulationImage(false), autoUpdate(false), freq(0.01f), fps(0.0f), 
         framePeriod_T(0.0f), framePeriod_E(0)  {}
     ~FrameViewportFBO() {}
 
@@ -39,6 +39,7 @@ public:
 
     bool &isMorlet() { return morlet; }
     bool &getPCA() { return pca; }
+    bool &getAccumulationImage() { return accumulationImage; } // one sensor sized texture instead of a point per event
     int &getAutoUpdate() { return autoUpdate; }
     float &getFreq() { return freq; }
     float &getUpdateFPS() { return fps; }
@@ -55,6 +56,7 @@ public:
 private:
     bool morlet;
     bool pca;
+    bool accumulationImage;
     int autoUpdate;
     float freq;
     float fps;
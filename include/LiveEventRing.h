@@ -0,0 +1,73 @@
+#pragma once
+#ifndef LIVE_EVENT_RING_H
+#define LIVE_EVENT_RING_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "EventColumns.h"
+
+/*
+    Bounded, time ordered hand-off between the live ingest thread (single producer) and the render thread (single
+    consumer).
+
+    Neither side ever waits on the other. Once the ring is full the producer simply overwrites the oldest events. The
+    consumer copies the events it has not seen yet and afterwards checks how far the producer got meanwhile; whatever
+    may have been overwritten during the copy is discarded, seqlock style. A slow frame therefore loses old events
+    instead of stalling ingest, and a burst of events never blocks a frame.
+*/
+
+/**
+ * @brief Lock-free single producer / single consumer ring of events that evicts the oldest when full.
+ */
+class LiveEventRing {
+    public:
+        /**
+         * @brief Drops all events and resizes the ring. Must not race with push() / read().
+         * @param capacity rounded up to a power of two
+         */
+        void reset(size_t capacity);
+
+        size_t capacity() const { return timestamps.size(); }
+
+        /**
+         * @brief Producer: appends one event, overwriting the oldest one when full. Events older than the newest one
+         * pushed so far are dropped, so the ring stays time ordered. Only visible to read() after publish().
+         */
+        void push(uint16_t evtX, uint16_t evtY, int64_t timestamp, bool evtPolarity);
+
+        /**
+         * @brief Producer: makes every event pushed so far visible to the consumer.
+         */
+        void publish() { published.store(pushed, std::memory_order_release); }
+
+        /**
+         * @brief Consumer: appends the published events from index from on to out, skipping those already evicted.
+         * @param from index of the first wanted event, counted over everything ever pushed
+         * @param out
+         * @return index one past the last published event, i.e. the from of the next call
+         */
+        uint64_t read(uint64_t from, EventColumns &out) const;
+
+    private:
+        std::vector<uint16_t> x;
+        std::vector<uint16_t> y;
+        std::vector<int64_t> timestamps;
+        std::vector<uint8_t> polarity;
+        uint64_t mask = 0;
+
+        // Producer side
+        uint64_t pushed = 0;
+        int64_t newest = INT64_MIN;
+
+        std::atomic<uint64_t> published{0}; // events [0, published) may be read
+        std::atomic<uint64_t> claimed{0};   // slot of event claimed - 1 is being written, evicting event claimed - 1 - capacity
+
+        // Consumer side staging, raw copies of the slots until they are validated
+        mutable std::vector<uint16_t> stagingX;
+        mutable std::vector<uint16_t> stagingY;
+        mutable std::vector<int64_t> stagingTimestamps;
+        mutable std::vector<uint8_t> stagingPolarity;
+};
+
+#endif // LIVE_EVENT_RING_H
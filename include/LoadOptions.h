@@ -0,0 +1,103 @@
+#pragma once
+#ifndef LOAD_OPTIONS_H
+#define LOAD_OPTIONS_H
+
+#include <cstdint>
+
+/*
+    Settings that decide which events of a recording end up in EventData. They are applied while decoding, so anything
+    they exclude is never converted or stored, and they are part of the .novacache key (see EventCache.h).
+
+    A time range instead selects a slice of the recording through its TimeIndex. Range loads bypass the event cache,
+    which always holds a whole recording.
+
+    Region of interest and polarity filters are evaluated per event in the decode loop, so a recording restricted to
+    a part of the sensor only takes memory (and every later pass only takes time) for that part. Event decimation then
+    counts the events that pass them.
+
+    Event decimation is the exception: the cache keeps every event and the factor is applied to a copy in memory, so it
+    can be changed without decoding again (see EventData::updateDecimation).
+*/
+
+/**
+ * @brief Load time decimation settings, edited from the "Load" panel and applied on the next load; modFreq also to the
+ * loaded recording.
+ */
+struct LoadOptions {
+    static const int DECIMATE_EVENTS = 0; // values must match ImGui::Combo order in utils.cpp
+    static const int DECIMATE_PACKETS = 1;
+    static const int DECIMATE_TIME = 2;
+
+    static const int POLARITY_ALL = 0; // values must match ImGui::Combo order in utils.cpp
+    static const int POLARITY_POSITIVE = 1;
+    static const int POLARITY_NEGATIVE = 2;
+
+    int decimationType = DECIMATE_EVENTS;
+    uint32_t modFreq = 1; // DECIMATE_EVENTS: keep every modFreq'th event
+    uint32_t packetStride = 1; // DECIMATE_PACKETS: keep one of every packetStride packets, the rest are never read
+    float keep_ms = 1.0f; // DECIMATE_TIME: keep the first keep_ms of every period_ms, the rest is never read
+    float period_ms = 10.0f;
+    float rangeStart_s = 0.0f; // seconds since the start of the recording; rangeEnd_s <= rangeStart_s loads all of it
+    float rangeEnd_s = 0.0f;
+    bool roiEnabled = false; // keep only events with roiMinX <= x <= roiMaxX and roiMinY <= y <= roiMaxY
+    int roiMinX = 0;
+    int roiMinY = 0;
+    int roiMaxX = 65535; // up to the sensor edge until narrowed
+    int roiMaxY = 65535;
+    int polarity = POLARITY_ALL;
+
+    /**
+     * @brief Event modulo actually applied during conversion; the packet / time modes skip data instead.
+     */
+    uint32_t effectiveModFreq() const { return decimationType == DECIMATE_EVENTS ? modFreq : 1; }
+
+    bool hasTimeRange() const { return rangeEnd_s > rangeStart_s; }
+
+    bool hasEventFilter() const { return roiEnabled || polarity != POLARITY_ALL; }
+
+    /**
+     * @brief Region of interest and polarity filter, what the decode loops ask for every event.
+     */
+    bool keepsEvent(int x, int y, bool positive) const {
+        if (roiEnabled && (x < roiMinX || x > roiMaxX || y < roiMinY || y > roiMaxY)) {
+            return false;
+        }
+        return polarity == POLARITY_ALL || positive == (polarity == POLARITY_POSITIVE);
+    }
+
+    /**
+     * @brief Same selection without event decimation, what the cache of an event decimated load is keyed with.
+     */
+    LoadOptions fullResolution() const {
+        LoadOptions full = *this;
+        if (decimationType == DECIMATE_EVENTS) {
+            full.modFreq = 1;
+        }
+        return full;
+    }
+
+    /**
+     * @brief Whether both settings keep the same events, ignoring parameters of the modes that are not selected.
+     */
+    bool selectsSameEvents(const LoadOptions &other) const {
+        if (decimationType != other.decimationType || hasTimeRange() != other.hasTimeRange()) {
+            return false;
+        }
+        if (hasTimeRange() && (rangeStart_s != other.rangeStart_s || rangeEnd_s != other.rangeEnd_s)) {
+            return false;
+        }
+        if (roiEnabled != other.roiEnabled || polarity != other.polarity) {
+            return false;
+        }
+        if (roiEnabled && (roiMinX != other.roiMinX || roiMinY != other.roiMinY || roiMaxX != other.roiMaxX || roiMaxY != other.roiMaxY)) {
+            return false;
+        }
+        switch (decimationType) {
+            case DECIMATE_PACKETS: return packetStride == other.packetStride;
+            case DECIMATE_TIME: return keep_ms == other.keep_ms && period_ms == other.period_ms;
+            default: return modFreq == other.modFreq;
+        }
+    }
+};
+
+#endif // LOAD_OPTIONS_H
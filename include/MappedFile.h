@@ -0,0 +1,69 @@
+#pragma once
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+/*
+    Thin RAII wrapper around an OS file mapping (MapViewOfFile on Windows, mmap elsewhere).
+
+    Mapping lets large binary files be handed straight to EventData / glBufferSubData without reading them into a
+    std::vector first; pages are only faulted in when touched. Files made with create are mapped writable instead, so
+    several threads can fill disjoint parts of an output file and the OS writes the pages back.
+*/
+
+/**
+ * @brief Memory mapping of a whole file, read-only unless it was created here.
+ */
+class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+        MappedFile(MappedFile &&other) noexcept;
+        MappedFile &operator=(MappedFile &&other) noexcept;
+
+        /**
+         * @brief Maps the file at path. Any previously mapped file is closed first.
+         * @param path
+         * @return true if the file exists, is non-empty and could be mapped
+         */
+        bool open(const std::string &path);
+
+        /**
+         * @brief Creates (or truncates) the file at path with size bytes and maps it writable. Any previously mapped
+         * file is closed first.
+         * @param path
+         * @param size must be > 0
+         * @return true if the file could be created, sized and mapped
+         */
+        bool create(const std::string &path, size_t size);
+
+        /**
+         * @brief Unmaps the file and releases all handles. Safe to call on a closed object.
+         */
+        void close();
+
+        bool isOpen() const { return ptr != nullptr; }
+        const std::byte *data() const { return static_cast<const std::byte *>(ptr); }
+        size_t size() const { return length; }
+
+        /**
+         * @brief Writable view of a file opened with create, nullptr otherwise.
+         */
+        std::byte *writableData() { return writable ? static_cast<std::byte *>(ptr) : nullptr; }
+
+    private:
+        void *ptr = nullptr;
+        size_t length = 0;
+        bool writable = false;
+
+        // HANDLEs on Windows, fd stored in fileHandle elsewhere; kept as void* so windows.h stays out of the header
+        void *fileHandle = nullptr;
+        void *mappingHandle = nullptr;
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,128 @@
+#pragma once
+#ifndef PAGED_EVENT_STORE_H
+#define PAGED_EVENT_STORE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "EventColumns.h"
+
+/*
+    Out-of-core access to a time sorted event file that is too large to keep in RAM.
+
+    The payload (event columns as laid out by EventColumnsLayout, e.g. the body of a .novacache) is split into fixed
+    size blocks of BLOCK_EVENTS events. At most maxResidentBlocks of them are held in memory; the least recently used
+    block is evicted when another one has to be read. The first and last timestamp of every block are read once on
+    open, so time lookups only ever touch the one or two blocks that actually contain the answer.
+
+    setWindow() tells the store which events the viewer currently looks at. Blocks just past the window, in the
+    direction the window last moved, are then read on a background thread so playback rarely waits on disk.
+*/
+
+/**
+ * @brief LRU block cache over an on-disk array of time sorted events.
+ */
+class PagedEventStore {
+    public:
+        // ~8 MB per block, a multiple of CHUNK_EVENTS so blocks own whole polarity words and chunk bases
+        static const size_t BLOCK_EVENTS = 1 << 20;
+        static const size_t BLOCK_BYTES = BLOCK_EVENTS * (2 * sizeof(uint16_t) + sizeof(uint32_t)) + BLOCK_EVENTS / 8
+            + BLOCK_EVENTS / EventColumns::CHUNK_EVENTS * sizeof(int64_t);
+        static const size_t READAHEAD_BLOCKS = 2;
+
+        // A resident block; holding it keeps the memory alive even if the store evicts it meanwhile
+        using Block = std::shared_ptr<const EventColumns>;
+
+        PagedEventStore() = default;
+        ~PagedEventStore();
+
+        PagedEventStore(const PagedEventStore &) = delete;
+        PagedEventStore &operator=(const PagedEventStore &) = delete;
+
+        /**
+         * @brief Opens the event file and reads the per block time bounds. Any previously opened file is closed first.
+         * @param path file holding the events
+         * @param dataOffset byte offset of the columns in the file
+         * @param eventCount number of events stored from dataOffset on
+         * @param maxResidentBlocks memory budget in blocks, at least READAHEAD_BLOCKS + 1 are always allowed
+         * @return false if the file cannot be read
+         */
+        bool open(const std::string &path, uint64_t dataOffset, uint64_t eventCount, size_t maxResidentBlocks);
+
+        /**
+         * @brief Stops readahead and drops every resident block. Safe to call on a closed store.
+         */
+        void close();
+
+        bool isOpen() const { return eventCount > 0; }
+        size_t size() const { return eventCount; }
+        size_t getBlockCount() const { return blockFirstT.size(); }
+        size_t getMaxResidentBlocks() const { return maxResidentBlocks; }
+        static size_t blockOf(size_t eventIndex) { return eventIndex / BLOCK_EVENTS; }
+        static size_t blockStart(size_t block) { return block * BLOCK_EVENTS; }
+
+        /**
+         * @brief Returns block b, reading it from disk on a miss.
+         * @param b
+         */
+        Block getBlock(size_t b) const;
+
+        int64_t getTimestamp(size_t i) const;
+
+        /**
+         * @brief Index of the first event with a timestamp >= timestamp, size() if there is none.
+         */
+        size_t lowerBound(int64_t timestamp) const;
+
+        /**
+         * @brief Index of the first event with a timestamp > timestamp, size() if there is none.
+         */
+        size_t upperBound(int64_t timestamp) const;
+
+        /**
+         * @brief Hints the event range being viewed so the blocks after it (or before it, when moving backwards) are
+         * read ahead in the background.
+         * @param first
+         * @param last
+         */
+        void setWindow(size_t first, size_t last);
+
+    private:
+        std::shared_ptr<EventColumns> readBlock(size_t b) const;
+        bool readAt(uint64_t offset, void *dst, size_t bytes) const;
+        Block insertBlock(size_t b, Block block) const;
+        void readaheadWorker();
+
+        EventColumnsLayout layout{};
+        size_t eventCount = 0;
+        size_t maxResidentBlocks = 0;
+        std::vector<int64_t> blockFirstT;
+        std::vector<int64_t> blockLastT;
+
+        // Reads are serialized, the render thread and the readahead thread share the stream
+        mutable std::ifstream file;
+        mutable std::mutex fileMutex;
+
+        // LRU: front is the most recently used block
+        mutable std::mutex residentMutex;
+        mutable std::list<size_t> lru;
+        mutable std::unordered_map<size_t, std::pair<Block, std::list<size_t>::iterator>> resident;
+
+        std::thread readaheadThread;
+        std::mutex readaheadMutex;
+        std::condition_variable readaheadCv;
+        std::deque<size_t> readaheadQueue;
+        bool stopReadahead = false;
+        size_t windowFirst = 0;
+        bool movingBackwards = false;
+};
+
+#endif // PAGED_EVENT_STORE_H
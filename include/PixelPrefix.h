@@ -0,0 +1,80 @@
+#pragma once
+#ifndef PIXEL_PREFIX_H
+#define PIXEL_PREFIX_H
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "EventArena.h"
+#include "EventColumns.h"
+
+/*
+    Per pixel running event counts for box shutter DCE frames.
+
+    With the box shutter every event of a polarity adds the same color, so a frame only depends on how
+    many positive and negative events each pixel got within the shutter. Checkpoints every `stride` events hold the
+    counts of all events before them, per pixel and polarity, so the counts of any event range are the difference of
+    the two checkpoints inside it plus a scan of the at most 2 * stride events between them and the range's ends. A frame
+    then costs O(pixels + stride) however long the shutter is.
+
+    The checkpoints take (checkpoints + 1) * pixels * 8 bytes; as many are placed as the memory budget allows, but no
+    closer than MIN_STRIDE events apart.
+*/
+
+/**
+ * @brief Checkpointed per pixel counts of positive and negative events over a time sorted event set.
+ */
+class PixelPrefix {
+    public:
+        static const size_t MIN_STRIDE = size_t(1) << 16;
+
+        /**
+         * @brief Rebuilds the checkpoints in parallel; leaves the structure empty if events are too few or the budget
+         * does not fit two checkpoints.
+         * @param events
+         * @param cameraResolution sensor size, events outside are not counted
+         * @param budgetBytes
+         */
+        void build(const EventColumnsView &events, glm::vec2 cameraResolution, size_t budgetBytes);
+
+        void clear();
+
+        bool isEmpty() const { return checkpoints == 0; }
+        size_t getEventCount() const { return eventCount; } // size of the event set built over
+        int getWidth() const { return width; }
+        int getHeight() const { return height; }
+
+        /**
+         * @brief Per pixel counts of the events [first, last] of events, which must be the set built over.
+         * @param events
+         * @param first
+         * @param last
+         * @param positive resized to width * height
+         * @param negative resized to width * height
+         */
+        void count(const EventColumnsView &events, size_t first, size_t last, ArenaVector<uint32_t> &positive,
+            ArenaVector<uint32_t> &negative) const;
+
+        /**
+         * @brief Adds every event within width x height to the per pixel counts, or takes it away again if subtract.
+         * Safe for overlapping calls, the counts are updated atomically.
+         * @param events
+         * @param width
+         * @param height
+         * @param subtract
+         * @param positive width * height counts
+         * @param negative width * height counts
+         */
+        static void addEvents(const EventColumnsView &events, int width, int height, bool subtract, uint32_t *positive,
+            uint32_t *negative);
+
+    private:
+        int width = 0;
+        int height = 0;
+        size_t eventCount = 0;
+        size_t stride = 0;      // events between two checkpoints
+        size_t checkpoints = 0; // checkpoint k = 0..checkpoints counts the events [0, k * stride)
+        ArenaVector<uint32_t> positiveCounts; // checkpoint major, width * height per checkpoint
+        ArenaVector<uint32_t> negativeCounts;
+};
+
+#endif // PIXEL_PREFIX_H
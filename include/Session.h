@@ -0,0 +1,84 @@
+#pragma once
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "EventData.h"
+
+/*
+    An ordered list of recordings played as one timeline, e.g. a capture split into consecutive .aedat4 files.
+
+    A session is opened from a single recording or from an .m3u playlist: one path per line, relative to the playlist,
+    lines starting with # are ignored. Only the shown recording and the one after it are kept. Once the shown one is
+    complete, the next one is decoded on its own loader thread and streamed into its own buffers, so stepping to it at
+    the end of playback is a pointer swap (see EventData::continueFrom).
+*/
+
+/**
+ * @brief Playlist of recordings with background prefetch of the next one.
+ */
+class Session {
+    public:
+        static bool isPlaylist(const std::string &path);
+
+        /**
+         * @brief Paths listed in an .m3u playlist, resolved against its directory.
+         * @param path
+         * @return empty if the playlist cannot be read
+         */
+        static std::vector<std::string> readPlaylist(const std::string &path);
+
+        /**
+         * @brief Replaces the session with path, a recording or a playlist, and starts loading its first recording.
+         * @param path
+         * @return false if there is nothing to play
+         */
+        bool open(const std::string &path);
+
+        /**
+         * @brief Drops all recordings, including the shown one.
+         */
+        void close();
+
+        /**
+         * @brief Asks for the recording at index to be shown, done by the next update().
+         */
+        void select(size_t index) { requested = index; }
+
+        /**
+         * @brief Switches to a selected recording and keeps the prefetch of the next one going. Must be called from the
+         * thread owning the GL context, once per frame.
+         * @return true if current() changed
+         */
+        bool update();
+
+        std::shared_ptr<EventData> current() const { return shown; }
+        size_t size() const { return recordings.size(); }
+        size_t getCurrentIndex() const { return shownIndex; }
+        const std::string &getRecording(size_t index) const { return recordings[index]; }
+        bool hasNext() const { return shownIndex + 1 < recordings.size(); }
+
+        /**
+         * @brief Whether the recording after the shown one is completely loaded, i.e. can be switched to without a stall.
+         */
+        bool isNextReady() const { return prefetched && prefetchedIndex == shownIndex + 1 && prefetched->isLoadComplete(); }
+        float getNextProgress() const { return prefetched ? prefetched->getLoadProgress() : 0.0f; }
+
+    private:
+        /**
+         * @brief Makes the recording at index the shown one, taking over the prefetched recording if it is that one.
+         */
+        void show(size_t index);
+
+        std::vector<std::string> recordings;
+        std::shared_ptr<EventData> shown;
+        size_t shownIndex = 0;
+        std::shared_ptr<EventData> prefetched;
+        size_t prefetchedIndex = 0;
+        size_t requested = SIZE_MAX;
+};
+
+#endif // SESSION_H
@@ -0,0 +1,110 @@
+#pragma once
+#ifndef TIME_INDEX_H
+#define TIME_INDEX_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <dv-processing/io/mono_camera_recording.hpp>
+
+/*
+    Sparse time index of a recording's event stream, stored next to the .aedat4 as <recording>.novaindex.
+
+    One entry every INTERVAL_US or so maps a timestamp to the number of events before it and the byte offset of the
+    packet holding it. Entries only start on packet boundaries that no timestamp straddles, so the counts are exact.
+    They come from the file's packet table where it has them; whatever the table does not know is counted by
+    decoding those intervals, in parallel. Either way this is paid once per recording.
+
+    A time range load (LoadOptions::hasTimeRange) then decodes nothing before its start: the packets are seeked to and
+    the index supplies the global index of the first event, so event decimation keeps the same events as a full load.
+*/
+
+/**
+ * @brief On-disk header of a .novaindex file, followed by entryCount TimeIndex::Entry.
+ */
+struct TimeIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t intervalUs;
+    uint64_t sourceChecksum;
+    uint64_t entryCount;
+    uint64_t eventCount;
+    int64_t earliestTimestamp;
+    int64_t latestTimestamp;
+};
+
+/**
+ * @brief Coarse timestamp -> event index / packet offset lookup, built once and persisted as a sidecar.
+ */
+class TimeIndex {
+    public:
+        static constexpr uint32_t VERSION = 1;
+        static constexpr char MAGIC[8] = {'N', 'O', 'V', 'A', 'T', 'I', 'D', 'X'};
+        static const int64_t INTERVAL_US = 100'000;
+
+        /**
+         * @brief Events with timestamps in [timestamp, next entry's timestamp) start at firstEvent, in the packet at
+         * byteOffset (-1 if the file has no packet table).
+         */
+        struct Entry {
+            int64_t timestamp;
+            uint64_t firstEvent;
+            int64_t byteOffset;
+        };
+
+        /**
+         * @brief Path of the index belonging to a recording.
+         * @param recording path to the .aedat4 file
+         */
+        static std::string indexPathFor(const std::string &recording);
+
+        /**
+         * @brief Reads the index of the recording if it exists and matches the version and source checksum.
+         * @param recording path to the .aedat4 file
+         * @return true if the index is valid and loaded
+         */
+        bool open(const std::string &recording);
+
+        /**
+         * @brief Builds the index from the recording's packet table, decoding the intervals it has no counts for in
+         * parallel, and writes it next to the recording.
+         * @param recording path to the .aedat4 file
+         * @param cancel checked between intervals; a cancelled build leaves the index empty and writes nothing
+         * @return false if cancelled or the recording has no events
+         */
+        bool build(const std::string &recording, const std::atomic<bool> &cancel);
+
+        void clear();
+
+        bool empty() const { return entries.empty(); }
+        size_t size() const { return entries.size(); }
+        uint64_t getEventCount() const { return eventCount; }
+
+        /**
+         * @brief Last entry at or before timestamp, nullptr if timestamp precedes every event.
+         */
+        const Entry *locate(int64_t timestamp) const;
+
+        /**
+         * @brief Exact number of events with a timestamp < timestamp. Only the part of one interval before timestamp is
+         * decoded, through reader.
+         * @param timestamp
+         * @param reader recording the index belongs to
+         */
+        uint64_t countBefore(int64_t timestamp, dv::io::MonoCameraRecording &reader) const;
+
+    private:
+        /**
+         * @brief Writes the sidecar under a temporary name and renames it into place.
+         */
+        void write(const std::string &recording) const;
+
+        uint64_t sourceChecksum = 0;
+        uint64_t eventCount = 0;
+        int64_t earliestTimestamp = 0;
+        int64_t latestTimestamp = 0;
+        std::vector<Entry> entries;
+};
+
+#endif // TIME_INDEX_H
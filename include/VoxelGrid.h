@@ -0,0 +1,61 @@
+#pragma once
+#ifndef VOXEL_GRID_H
+#define VOXEL_GRID_H
+
+#include <span>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+#include "EventColumns.h"
+
+/*
+    Density preserving downsampling of the event cloud.
+
+    Events are binned into an (x, y, t) voxel grid and at most `cap` events are kept per voxel. Every kept event carries
+    a weight (events in its voxel / events kept in its voxel), so a DCE frame built from the reduced set still sums to
+    the same per voxel contribution. Unlike modFreq this leaves sparse regions untouched and only thins out dense ones.
+*/
+
+/**
+ * @brief User settings of the voxel grid downsampling, edited from the "Load" panel.
+ */
+struct VoxelGridOptions {
+    bool enabled = false;
+    int cellXY = 4; // voxel side in pixels
+    float cell_ms = 1.0f; // voxel depth in milliseconds
+    int cap = 4; // max events kept per voxel
+
+    bool operator==(const VoxelGridOptions &other) const = default;
+};
+
+/**
+ * @brief Holds the downsampled copy of an event set together with per event weights.
+ */
+class VoxelGrid {
+    public:
+        /**
+         * @brief Rebuilds the reduced set from time sorted events in parallel.
+         * @param events
+         * @param cameraResolution sensor size, bounds the x / y cell indices
+         * @param options
+         */
+        void build(const EventColumnsView &events, glm::vec2 cameraResolution, const VoxelGridOptions &options);
+
+        void clear();
+
+        EventColumnsView getParticles() const { return particles.view(); }
+        const std::vector<float> &getWeights() const { return weights; }
+        bool isEmpty() const { return particles.empty(); }
+
+        /**
+         * @brief Index range in the reduced set covering the timestamps [ts_L, ts_R].
+         * @return first and last index, last < first if the interval holds no reduced event
+         */
+        std::pair<int, int> getRange(int64_t ts_L, int64_t ts_R) const;
+
+    private:
+        EventColumns particles;
+        std::vector<float> weights;
+};
+
+#endif // VOXEL_GRID_H
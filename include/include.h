@@ -38,6 +38,8 @@
 #include "Mesh.h"
 #include "BPMaterial.h"
 #include "EventData.h"
+#include "Session.h"
+#include "EventImporter.h"
 #include "MainScene.h"
 #include "frameScene.h"
 #include "ContributionFunc.h"
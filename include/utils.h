@@ -11,6 +11,7 @@
 class Program;
 class BaseViewportFBO;
 class EventData;
+class Session;
 
 /**
  * @brief Struct to hold context information for the GLFW window. This allows for callback functions to access information within other scopes.
@@ -29,6 +30,7 @@ std::string OpenFileDialog();
 Program genPhongProg(const std::string &resource_dir);
 Program genInstProg(const std::string &resource_dir);
 Program genBasicProg(const std::string &resource_dir);
+Program genFrameImageProg(const std::string &resource_dir);
 
 void sendToPhongShader(const Program &prog, const MatrixStack &P, const MatrixStack &MV, const vec3 &lightPos, const vec3 &lightCol, const BPMaterial &mat);
 
@@ -55,6 +57,7 @@ void drawGUIDockspace();
  * @param mainSceneFBO 
  * @param frameScenceFBO 
  * @param evtData 
+ * @param session recordings of the opened file or playlist
  * @param datafilepath 
  * @param video_name 
  * @param recording 
@@ -62,8 +65,8 @@ void drawGUIDockspace();
  * @param loadFile 
  */
 void drawGUI(const Camera& camera, float fps, float &particle_scale, bool &is_mainViewportHovered,
-    BaseViewportFBO &mainSceneFBO, FrameViewportFBO &frameScenceFBO, std::shared_ptr<EventData> &evtData, std::string &datafilepath, 
-    std::string &video_name, bool &recording, std::string& datadirectory, bool &loadFile);
+    BaseViewportFBO &mainSceneFBO, FrameViewportFBO &frameScenceFBO, std::shared_ptr<EventData> &evtData, Session &session,
+    std::string &datafilepath, std::string &video_name, bool &recording, std::string& datadirectory, bool &loadFile);
 
 float randFloat();
 glm::vec3 randXYZ();
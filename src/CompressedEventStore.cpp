@@ -0,0 +1,326 @@
+#include "CompressedEventStore.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define COMPRESSED_EVENT_STORE_SSE2 1
+#endif
+
+static uint32_t maskOf(int bits) {
+    return bits >= 32 ? 0xFFFFFFFFu : (1u << bits) - 1;
+}
+
+static size_t groupsFor(size_t values) {
+    return (values + CompressedEventStore::GROUP - 1) / CompressedEventStore::GROUP;
+}
+
+static size_t packedWords(size_t values, int bits) {
+    return groupsFor(values) * CompressedEventStore::LANES * bits;
+}
+
+/*
+    Vertical bit packing of groups of 128 values: value 4k + l goes to lane l at bit k * bits of that lane's stream,
+    and word j of lane l is stored at out[j * 4 + l]. values must hold whole groups (zero padded).
+*/
+static void pack(const uint32_t *values, size_t groups, int bits, uint32_t *out) {
+    if (bits == 0) {
+        return;
+    }
+
+    const uint32_t mask = maskOf(bits);
+    for (size_t g = 0; g < groups; g++) {
+        const uint32_t *in = values + g * CompressedEventStore::GROUP;
+        uint32_t *group = out + g * CompressedEventStore::LANES * bits;
+        for (int k = 0; k < 32; k++) {
+            int bit = k * bits, j = bit >> 5, s = bit & 31;
+            for (int l = 0; l < 4; l++) {
+                uint32_t v = in[k * 4 + l] & mask;
+                group[j * 4 + l] |= v << s;
+                if (s + bits > 32) {
+                    group[(j + 1) * 4 + l] |= v >> (32 - s);
+                }
+            }
+        }
+    }
+}
+
+/*
+    Inverse of pack() for one group: 4 values per step, with the same shift and mask on every lane.
+*/
+static void unpackGroup(const uint32_t *in, int bits, uint32_t *out) {
+    const uint32_t mask = maskOf(bits);
+#ifdef COMPRESSED_EVENT_STORE_SSE2
+    const __m128i vmask = _mm_set1_epi32(static_cast<int>(mask));
+    for (int k = 0; k < 32; k++) {
+        int bit = k * bits, j = bit >> 5, s = bit & 31;
+        __m128i v = _mm_srl_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + j * 4)), _mm_cvtsi32_si128(s));
+        if (s + bits > 32) {
+            __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + (j + 1) * 4));
+            v = _mm_or_si128(v, _mm_sll_epi32(next, _mm_cvtsi32_si128(32 - s)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + k * 4), _mm_and_si128(v, vmask));
+    }
+#else
+    for (int k = 0; k < 32; k++) {
+        int bit = k * bits, j = bit >> 5, s = bit & 31;
+        for (int l = 0; l < 4; l++) {
+            uint32_t v = in[j * 4 + l] >> s;
+            if (s + bits > 32) {
+                v |= in[(j + 1) * 4 + l] << (32 - s);
+            }
+            out[k * 4 + l] = v & mask;
+        }
+    }
+#endif
+}
+
+static void unpack(const uint32_t *in, size_t groups, int bits, uint32_t *out) {
+    if (bits == 0) {
+        std::fill(out, out + groups * CompressedEventStore::GROUP, 0u);
+        return;
+    }
+    for (size_t g = 0; g < groups; g++) {
+        unpackGroup(in + g * CompressedEventStore::LANES * bits, bits, out + g * CompressedEventStore::GROUP);
+    }
+}
+
+/*
+    In place inclusive prefix sum over whole groups, wrapping like the uint32 deltas it undoes.
+*/
+static void prefixSum(uint32_t *values, size_t groups) {
+    size_t n = groups * CompressedEventStore::GROUP;
+#ifdef COMPRESSED_EVENT_STORE_SSE2
+    __m128i carry = _mm_setzero_si128();
+    for (size_t i = 0; i < n; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+        v = _mm_add_epi32(v, carry);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(values + i), v);
+        carry = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+#else
+    uint32_t running = 0;
+    for (size_t i = 0; i < n; i++) {
+        running += values[i];
+        values[i] = running;
+    }
+#endif
+}
+
+CompressedEventStore::Block CompressedEventStore::encodeBlock(const EventColumnsView &events) {
+    const size_t n = events.size();
+    const size_t padded = groupsFor(n) * GROUP;
+
+    Block block{};
+    block.count = static_cast<uint32_t>(n);
+    block.firstTimestamp = events.getTimestamp(0);
+    block.lastTimestamp = events.getTimestamp(n - 1);
+
+    auto [minX, maxX] = std::minmax_element(events.x.begin(), events.x.end());
+    auto [minY, maxY] = std::minmax_element(events.y.begin(), events.y.end());
+    block.minX = *minX;
+    block.minY = *minY;
+    block.xBits = static_cast<uint8_t>(std::bit_width(static_cast<uint32_t>(*maxX - *minX)));
+    block.yBits = static_cast<uint8_t>(std::bit_width(static_cast<uint32_t>(*maxY - *minY)));
+
+    // Deltas between consecutive offsets, the first event is at firstTimestamp itself
+    std::vector<uint32_t> deltas(padded, 0);
+    uint32_t bitCounts[33] = {};
+    for (size_t i = 1; i < n; i++) {
+        deltas[i] = events.dt[i] - events.dt[i - 1];
+    }
+    for (size_t i = 0; i < n; i++) {
+        bitCounts[std::bit_width(deltas[i])]++;
+    }
+
+    // Width minimizing packed bits plus 64 bits per exception
+    uint64_t bestCost = UINT64_MAX;
+    uint32_t exceptions = 0;
+    for (int bits = 32; bits >= 0; bits--) {
+        uint64_t cost = static_cast<uint64_t>(padded) * bits + 64ull * exceptions;
+        if (cost <= bestCost) {
+            bestCost = cost;
+            block.dtBits = static_cast<uint8_t>(bits);
+            block.exceptionCount = exceptions;
+        }
+        exceptions += bitCounts[bits];
+    }
+
+    size_t xWords = packedWords(n, block.xBits);
+    size_t yWords = packedWords(n, block.yBits);
+    size_t dtWords = packedWords(n, block.dtBits);
+    size_t polarityWords = 2 * EventColumns::wordsFor(n);
+    block.words.assign(xWords + yWords + dtWords + polarityWords + 2 * block.exceptionCount, 0);
+    uint32_t *out = block.words.data();
+
+    std::vector<uint32_t> values(padded, 0);
+    for (size_t i = 0; i < n; i++) {
+        values[i] = events.x[i] - block.minX;
+    }
+    pack(values.data(), groupsFor(n), block.xBits, out);
+    out += xWords;
+
+    for (size_t i = 0; i < n; i++) {
+        values[i] = events.y[i] - block.minY;
+    }
+    pack(values.data(), groupsFor(n), block.yBits, out);
+    out += yWords;
+
+    pack(deltas.data(), groupsFor(n), block.dtBits, out);
+    out += dtWords;
+
+    // Polarity as is, bits past the end cleared so decoding can copy whole words
+    std::memcpy(out, events.polarityBits + events.origin / 64, polarityWords * sizeof(uint32_t));
+    if (n & 63) {
+        uint64_t last;
+        std::memcpy(&last, out + polarityWords - 2, sizeof(last));
+        last &= (uint64_t(1) << (n & 63)) - 1;
+        std::memcpy(out + polarityWords - 2, &last, sizeof(last));
+    }
+    out += polarityWords;
+
+    for (size_t i = 0; i < n; i++) {
+        if (std::bit_width(deltas[i]) > block.dtBits) {
+            *out++ = static_cast<uint32_t>(i);
+            *out++ = deltas[i] >> block.dtBits;
+        }
+    }
+
+    return block;
+}
+
+void CompressedEventStore::decodeTimes(const Block &block, uint32_t *dt) {
+    alignas(16) uint32_t deltas[BLOCK_EVENTS];
+    const size_t groups = groupsFor(block.count);
+
+    const uint32_t *field = block.words.data() + packedWords(block.count, block.xBits) + packedWords(block.count, block.yBits);
+    unpack(field, groups, block.dtBits, deltas);
+
+    const uint32_t *exceptions = block.words.data() + block.words.size() - 2 * block.exceptionCount;
+    for (uint32_t e = 0; e < block.exceptionCount; e++) {
+        deltas[exceptions[2 * e]] |= exceptions[2 * e + 1] << block.dtBits;
+    }
+
+    prefixSum(deltas, groups);
+    std::memcpy(dt, deltas, block.count * sizeof(uint32_t));
+}
+
+void CompressedEventStore::decodeBlock(const Block &block, EventColumns &out, size_t at) {
+    alignas(16) uint32_t values[BLOCK_EVENTS];
+    const size_t groups = groupsFor(block.count);
+    const uint32_t *field = block.words.data();
+
+    unpack(field, groups, block.xBits, values);
+    for (size_t i = 0; i < block.count; i++) {
+        out.x[at + i] = static_cast<uint16_t>(block.minX + values[i]);
+    }
+    field += packedWords(block.count, block.xBits);
+
+    unpack(field, groups, block.yBits, values);
+    for (size_t i = 0; i < block.count; i++) {
+        out.y[at + i] = static_cast<uint16_t>(block.minY + values[i]);
+    }
+    field += packedWords(block.count, block.yBits) + packedWords(block.count, block.dtBits);
+
+    decodeTimes(block, out.dt.data() + at);
+
+    std::memcpy(out.polarityBits.data() + at / 64, field, EventColumns::wordsFor(block.count) * sizeof(uint64_t));
+    out.chunkBase[at / BLOCK_EVENTS] = block.firstTimestamp;
+}
+
+void CompressedEventStore::assign(const EventColumnsView &events) {
+    clear();
+    if (events.empty()) {
+        return;
+    }
+
+    const long long blockCount = static_cast<long long>((events.size() + BLOCK_EVENTS - 1) / BLOCK_EVENTS);
+    blocks.resize(blockCount);
+
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (long long b = 0; b < blockCount; b++) {
+        size_t first = blockStart(b);
+        blocks[b] = encodeBlock(events.subview(first, std::min(BLOCK_EVENTS, events.size() - first)));
+    }
+
+    blockLastT.reserve(blocks.size());
+    for (const Block &block : blocks) {
+        blockLastT.push_back(block.lastTimestamp);
+    }
+    eventCount = events.size();
+}
+
+void CompressedEventStore::clear() {
+    std::vector<Block>().swap(blocks);
+    std::vector<int64_t>().swap(blockLastT);
+    eventCount = 0;
+}
+
+size_t CompressedEventStore::getBytes() const {
+    size_t bytes = blocks.size() * (sizeof(Block) + sizeof(int64_t));
+    for (const Block &block : blocks) {
+        bytes += block.words.size() * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+void CompressedEventStore::decode(size_t firstBlock, size_t lastBlock, EventColumns &out) const {
+    lastBlock = std::min(lastBlock, blocks.size());
+    if (firstBlock >= lastBlock) {
+        out.clear();
+        return;
+    }
+
+    out.resize(std::min(blockStart(lastBlock), eventCount) - blockStart(firstBlock));
+
+    const long long first = static_cast<long long>(firstBlock);
+    const long long last = static_cast<long long>(lastBlock);
+    #pragma omp parallel for schedule(static)
+    for (long long b = first; b < last; b++) {
+        decodeBlock(blocks[b], out, blockStart(b - first));
+    }
+}
+
+int64_t CompressedEventStore::getTimestamp(size_t i) const {
+    const Block &block = blocks[blockOf(i)];
+    uint32_t dt[BLOCK_EVENTS];
+    decodeTimes(block, dt);
+    return block.firstTimestamp + dt[i - blockStart(blockOf(i))];
+}
+
+/*
+    Finds the block through the per block bounds, then decodes only its time column. If upper is set it finds the
+    first timestamp > target, otherwise the first >= target.
+*/
+static size_t searchBlock(int64_t firstTimestamp, const uint32_t *dt, size_t count, int64_t target, bool upper) {
+    return std::partition_point(dt, dt + count, [&](uint32_t offset) {
+        int64_t timestamp = firstTimestamp + offset;
+        return upper ? timestamp <= target : timestamp < target;
+    }) - dt;
+}
+
+size_t CompressedEventStore::lowerBound(int64_t timestamp) const {
+    size_t b = std::lower_bound(blockLastT.begin(), blockLastT.end(), timestamp) - blockLastT.begin();
+    if (b == blockLastT.size()) {
+        return eventCount;
+    }
+
+    uint32_t dt[BLOCK_EVENTS];
+    decodeTimes(blocks[b], dt);
+    return blockStart(b) + searchBlock(blocks[b].firstTimestamp, dt, blocks[b].count, timestamp, false);
+}
+
+size_t CompressedEventStore::upperBound(int64_t timestamp) const {
+    size_t b = std::upper_bound(blockLastT.begin(), blockLastT.end(), timestamp) - blockLastT.begin();
+    if (b == blockLastT.size()) {
+        return eventCount;
+    }
+
+    uint32_t dt[BLOCK_EVENTS];
+    decodeTimes(blocks[b], dt);
+    return blockStart(b) + searchBlock(blocks[b].firstTimestamp, dt, blocks[b].count, timestamp, true);
+}
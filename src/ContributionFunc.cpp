@@ -0,0 +1,277 @@
+#include "ContributionFunc.h"
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define NOVA_X86_KERNELS
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC compiles intrinsics of any instruction set as is, GCC and Clang only inside functions targeting it, which keeps
+// the rest of the build on its baseline
+#if defined(__GNUC__) || defined(__clang__)
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define KERNEL_TARGET(isa)
+#endif
+
+static const float PI = 3.14159265358979f;
+
+// Coefficients shared by every kernel, so they all evaluate the same polynomials
+static const float SIN_C3 = -1.0f / 6;
+static const float SIN_C5 = 1.0f / 120;
+static const float SIN_C7 = -1.0f / 5040;
+static const float SIN_C9 = 1.0f / 362880;
+static const float SIN_C11 = -1.0f / 39916800;
+static const float LN2 = 0.693147181f;
+static const float SQRT_HALF = 0.707106781f;
+static const uint32_t TURNS_LIMIT = 0x4B800000u; // 2^24
+static const uint32_t EXP2_LIMIT = 0x42FA0000u;  // 125
+
+// Limits |v| to that of the float with bits limit, keeping the sign. An integer min, so the kernel loop has no float
+// compare that would keep compilers from vectorizing it
+static inline float clampMagnitude(float v, uint32_t limit) {
+    const uint32_t bits = std::bit_cast<uint32_t>(v);
+    const uint32_t magnitude = bits & 0x7FFFFFFFu;
+    return std::bit_cast<float>((bits & 0x80000000u) | (magnitude < limit ? magnitude : limit));
+}
+
+// cos(2 pi turns): the fraction of a period is folded onto [0, 0.5] and cos(2 pi a) = sin(2 pi (0.25 - a)) taken by
+// its Taylor series to x^11 on [-pi / 2, pi / 2], error below 6e-8. Past 2^24 periods floats hold no fraction anyway
+static inline float cosTurns(float turns) {
+    turns = clampMagnitude(turns, TURNS_LIMIT);
+    float a = std::fabs(turns - static_cast<float>(static_cast<int32_t>(turns)));
+    a = 0.5f - std::fabs(a - 0.5f);
+    const float x = 2.0f * PI * (0.25f - a);
+    const float x2 = x * x;
+    return x * (1.0f + x2 * (SIN_C3 + x2 * (SIN_C5 + x2 * (SIN_C7 + x2 * (SIN_C9 + x2 * SIN_C11)))));
+}
+
+// 2^v for v <= 0: the integer part goes into the exponent bits, 2^frac = e^((frac + 1/2) ln 2) / sqrt(2) by its Taylor
+// series to x^6 for frac in (-1, 0], relative error below 2e-7. Flushes to ~2e-38 below 2^-125
+static inline float exp2Negative(float v) {
+    v = clampMagnitude(v, EXP2_LIMIT); // the result stays a normal float
+    const int32_t whole = static_cast<int32_t>(v);
+    const float x = (v - static_cast<float>(whole) + 0.5f) * LN2;
+    const float fraction = SQRT_HALF * (1.0f + x * (1.0f + x * (1.0f / 2 + x * (1.0f / 6 + x * (1.0f / 24
+        + x * (1.0f / 120 + x * (1.0f / 720)))))));
+    return std::bit_cast<float>((whole + 127) << 23) * fraction;
+}
+
+// Portable kernel, vectorized by the compiler for the build's baseline
+static void morletWeightsPortable(float f, float decay, float positiveScale, float negativeScale, const float *t,
+    const float *polarity, size_t n, float *weights) {
+    const float negativeScaleDelta = negativeScale - positiveScale;
+    for (size_t i = 0; i < n; i++) {
+        const float unweighted = cosTurns(f * t[i]) * exp2Negative(-decay * t[i] * t[i]) * polarity[i];
+        const float negative = static_cast<float>(std::bit_cast<uint32_t>(unweighted) >> 31); // sign bit, no branch
+        weights[i] = unweighted * (positiveScale + negativeScaleDelta * negative);
+    }
+}
+
+#ifdef NOVA_X86_KERNELS
+
+// The AVX2 and AVX-512 kernels are the portable one step for step, 8 and 16 events at a time
+
+KERNEL_TARGET("avx2,fma")
+static inline __m256 clampMagnitude8(__m256 v, uint32_t limit) {
+    const __m256i bits = _mm256_castps_si256(v);
+    const __m256i sign = _mm256_set1_epi32(static_cast<int32_t>(0x80000000u));
+    const __m256i magnitude = _mm256_min_epi32(_mm256_andnot_si256(sign, bits), _mm256_set1_epi32(static_cast<int32_t>(limit)));
+    return _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(sign, bits), magnitude));
+}
+
+KERNEL_TARGET("avx2,fma")
+static inline __m256 abs8(__m256 v) {
+    return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v);
+}
+
+KERNEL_TARGET("avx2,fma")
+static inline __m256 cosTurns8(__m256 turns) {
+    turns = clampMagnitude8(turns, TURNS_LIMIT);
+    __m256 a = abs8(_mm256_sub_ps(turns, _mm256_cvtepi32_ps(_mm256_cvttps_epi32(turns))));
+    a = _mm256_sub_ps(_mm256_set1_ps(0.5f), abs8(_mm256_sub_ps(a, _mm256_set1_ps(0.5f))));
+    const __m256 x = _mm256_mul_ps(_mm256_set1_ps(2.0f * PI), _mm256_sub_ps(_mm256_set1_ps(0.25f), a));
+    const __m256 x2 = _mm256_mul_ps(x, x);
+    __m256 p = _mm256_fmadd_ps(x2, _mm256_set1_ps(SIN_C11), _mm256_set1_ps(SIN_C9));
+    p = _mm256_fmadd_ps(x2, p, _mm256_set1_ps(SIN_C7));
+    p = _mm256_fmadd_ps(x2, p, _mm256_set1_ps(SIN_C5));
+    p = _mm256_fmadd_ps(x2, p, _mm256_set1_ps(SIN_C3));
+    p = _mm256_fmadd_ps(x2, p, _mm256_set1_ps(1.0f));
+    return _mm256_mul_ps(x, p);
+}
+
+KERNEL_TARGET("avx2,fma")
+static inline __m256 exp2Negative8(__m256 v) {
+    v = clampMagnitude8(v, EXP2_LIMIT);
+    const __m256i whole = _mm256_cvttps_epi32(v);
+    const __m256 x = _mm256_mul_ps(_mm256_add_ps(_mm256_sub_ps(v, _mm256_cvtepi32_ps(whole)), _mm256_set1_ps(0.5f)),
+        _mm256_set1_ps(LN2));
+    __m256 p = _mm256_fmadd_ps(x, _mm256_set1_ps(1.0f / 720), _mm256_set1_ps(1.0f / 120));
+    p = _mm256_fmadd_ps(x, p, _mm256_set1_ps(1.0f / 24));
+    p = _mm256_fmadd_ps(x, p, _mm256_set1_ps(1.0f / 6));
+    p = _mm256_fmadd_ps(x, p, _mm256_set1_ps(1.0f / 2));
+    p = _mm256_fmadd_ps(x, p, _mm256_set1_ps(1.0f));
+    p = _mm256_fmadd_ps(x, p, _mm256_set1_ps(1.0f));
+    const __m256 scale = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(whole, _mm256_set1_epi32(127)), 23));
+    return _mm256_mul_ps(scale, _mm256_mul_ps(_mm256_set1_ps(SQRT_HALF), p));
+}
+
+KERNEL_TARGET("avx2,fma")
+static void morletWeightsAvx2(float f, float decay, float positiveScale, float negativeScale, const float *t,
+    const float *polarity, size_t n, float *weights) {
+    const __m256 f8 = _mm256_set1_ps(f);
+    const __m256 negativeDecay8 = _mm256_set1_ps(-decay);
+    const __m256 positiveScale8 = _mm256_set1_ps(positiveScale);
+    const __m256 negativeScale8 = _mm256_set1_ps(negativeScale);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 t8 = _mm256_loadu_ps(t + i);
+        const __m256 envelope = exp2Negative8(_mm256_mul_ps(_mm256_mul_ps(negativeDecay8, t8), t8));
+        const __m256 unweighted = _mm256_mul_ps(_mm256_mul_ps(cosTurns8(_mm256_mul_ps(f8, t8)), envelope),
+            _mm256_loadu_ps(polarity + i));
+        // blendv picks by the sign bit, like the portable kernel
+        _mm256_storeu_ps(weights + i, _mm256_mul_ps(unweighted, _mm256_blendv_ps(positiveScale8, negativeScale8, unweighted)));
+    }
+    morletWeightsPortable(f, decay, positiveScale, negativeScale, t + i, polarity + i, n - i, weights + i);
+}
+
+// GCC 12's AVX-512 headers trip -Wmaybe-uninitialized on their own placeholder operands
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+KERNEL_TARGET("avx512f")
+static inline __m512 clampMagnitude16(__m512 v, uint32_t limit) {
+    const __m512i bits = _mm512_castps_si512(v);
+    const __m512i sign = _mm512_set1_epi32(static_cast<int32_t>(0x80000000u));
+    const __m512i magnitude = _mm512_min_epi32(_mm512_andnot_si512(sign, bits), _mm512_set1_epi32(static_cast<int32_t>(limit)));
+    return _mm512_castsi512_ps(_mm512_or_si512(_mm512_and_si512(sign, bits), magnitude));
+}
+
+KERNEL_TARGET("avx512f")
+static inline __m512 abs16(__m512 v) {
+    return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(v), _mm512_set1_epi32(0x7FFFFFFF)));
+}
+
+KERNEL_TARGET("avx512f")
+static inline __m512 cosTurns16(__m512 turns) {
+    turns = clampMagnitude16(turns, TURNS_LIMIT);
+    __m512 a = abs16(_mm512_sub_ps(turns, _mm512_cvtepi32_ps(_mm512_cvttps_epi32(turns))));
+    a = _mm512_sub_ps(_mm512_set1_ps(0.5f), abs16(_mm512_sub_ps(a, _mm512_set1_ps(0.5f))));
+    const __m512 x = _mm512_mul_ps(_mm512_set1_ps(2.0f * PI), _mm512_sub_ps(_mm512_set1_ps(0.25f), a));
+    const __m512 x2 = _mm512_mul_ps(x, x);
+    __m512 p = _mm512_fmadd_ps(x2, _mm512_set1_ps(SIN_C11), _mm512_set1_ps(SIN_C9));
+    p = _mm512_fmadd_ps(x2, p, _mm512_set1_ps(SIN_C7));
+    p = _mm512_fmadd_ps(x2, p, _mm512_set1_ps(SIN_C5));
+    p = _mm512_fmadd_ps(x2, p, _mm512_set1_ps(SIN_C3));
+    p = _mm512_fmadd_ps(x2, p, _mm512_set1_ps(1.0f));
+    return _mm512_mul_ps(x, p);
+}
+
+KERNEL_TARGET("avx512f")
+static inline __m512 exp2Negative16(__m512 v) {
+    v = clampMagnitude16(v, EXP2_LIMIT);
+    const __m512i whole = _mm512_cvttps_epi32(v);
+    const __m512 x = _mm512_mul_ps(_mm512_add_ps(_mm512_sub_ps(v, _mm512_cvtepi32_ps(whole)), _mm512_set1_ps(0.5f)),
+        _mm512_set1_ps(LN2));
+    __m512 p = _mm512_fmadd_ps(x, _mm512_set1_ps(1.0f / 720), _mm512_set1_ps(1.0f / 120));
+    p = _mm512_fmadd_ps(x, p, _mm512_set1_ps(1.0f / 24));
+    p = _mm512_fmadd_ps(x, p, _mm512_set1_ps(1.0f / 6));
+    p = _mm512_fmadd_ps(x, p, _mm512_set1_ps(1.0f / 2));
+    p = _mm512_fmadd_ps(x, p, _mm512_set1_ps(1.0f));
+    p = _mm512_fmadd_ps(x, p, _mm512_set1_ps(1.0f));
+    const __m512 scale = _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_add_epi32(whole, _mm512_set1_epi32(127)), 23));
+    return _mm512_mul_ps(scale, _mm512_mul_ps(_mm512_set1_ps(SQRT_HALF), p));
+}
+
+KERNEL_TARGET("avx512f")
+static void morletWeightsAvx512(float f, float decay, float positiveScale, float negativeScale, const float *t,
+    const float *polarity, size_t n, float *weights) {
+    const __m512 f16 = _mm512_set1_ps(f);
+    const __m512 negativeDecay16 = _mm512_set1_ps(-decay);
+    const __m512 positiveScale16 = _mm512_set1_ps(positiveScale);
+    const __m512 negativeScale16 = _mm512_set1_ps(negativeScale);
+    // The tail is one masked step, lanes past n are neither read nor written
+    for (size_t i = 0; i < n; i += 16) {
+        const __mmask16 lanes = n - i >= 16 ? static_cast<__mmask16>(0xFFFF) : static_cast<__mmask16>((1u << (n - i)) - 1);
+        const __m512 t16 = _mm512_maskz_loadu_ps(lanes, t + i);
+        const __m512 envelope = exp2Negative16(_mm512_mul_ps(_mm512_mul_ps(negativeDecay16, t16), t16));
+        const __m512 unweighted = _mm512_mul_ps(_mm512_mul_ps(cosTurns16(_mm512_mul_ps(f16, t16)), envelope),
+            _mm512_maskz_loadu_ps(lanes, polarity + i));
+        const __mmask16 negative = _mm512_cmplt_epi32_mask(_mm512_castps_si512(unweighted), _mm512_setzero_si512());
+        _mm512_mask_storeu_ps(weights + i, lanes,
+            _mm512_mul_ps(unweighted, _mm512_mask_blend_ps(negative, positiveScale16, negativeScale16)));
+    }
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // NOVA_X86_KERNELS
+
+bool MorletShutter::isSupported(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Portable:
+            return true;
+#if defined(NOVA_X86_KERNELS) && defined(_MSC_VER)
+        // CPUID for the instruction sets, XGETBV for the OS saving the registers they use
+        case Kernel::Avx2:
+        case Kernel::Avx512: {
+            int leaf1[4], leaf7[4];
+            __cpuid(leaf1, 1);
+            __cpuidex(leaf7, 7, 0);
+            const bool osxsave = (leaf1[2] & (1 << 27)) != 0;
+            const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+            if (kernel == Kernel::Avx2) {
+                const bool fma = (leaf1[2] & (1 << 12)) != 0;
+                const bool avx2 = (leaf7[1] & (1 << 5)) != 0;
+                return fma && avx2 && (xcr0 & 0x6) == 0x6;
+            }
+            const bool avx512f = (leaf7[1] & (1 << 16)) != 0;
+            return avx512f && (xcr0 & 0xE6) == 0xE6;
+        }
+#elif defined(NOVA_X86_KERNELS)
+        // Includes the OS support check
+        case Kernel::Avx2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case Kernel::Avx512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+        default:
+            return false;
+    }
+}
+
+MorletShutter::Kernel MorletShutter::getBestKernel() {
+    static const Kernel best = isSupported(Kernel::Avx512) ? Kernel::Avx512
+        : isSupported(Kernel::Avx2) ? Kernel::Avx2 : Kernel::Portable;
+    return best;
+}
+
+MorletShutter::MorletShutter(float f, Kernel kernel) : kernel(kernel), f(f), decay(4.0f / (MorletFunc::h * MorletFunc::h)),
+    positiveScale(BaseFunc::contribution), negativeScale(4.0f * BaseFunc::contribution) {}
+
+void MorletShutter::getWeights(const float *t, const float *polarity, size_t n, float *weights) const {
+    // exp(-4 ln 2 dt^2 / h^2) = 2^(-decay dt^2); one switch per batch, the kernels loop over the whole of it
+    switch (kernel) {
+#ifdef NOVA_X86_KERNELS
+        case Kernel::Avx512:
+            morletWeightsAvx512(f, decay, positiveScale, negativeScale, t, polarity, n, weights);
+            break;
+        case Kernel::Avx2:
+            morletWeightsAvx2(f, decay, positiveScale, negativeScale, t, polarity, n, weights);
+            break;
+#endif
+        default:
+            morletWeightsPortable(f, decay, positiveScale, negativeScale, t, polarity, n, weights);
+            break;
+    }
+}
@@ -0,0 +1,182 @@
+#include "EventArena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+#endif
+
+// Large blocks are rare (a handful per column and reload), so one lock over both maps is plenty
+struct ArenaState {
+    std::mutex mutex;
+    std::unordered_map<void *, size_t> usedBlocks; // block -> mapped size, deallocate only learns the requested one
+    std::multimap<size_t, void *> cachedBlocks;    // mapped size -> block
+    size_t cachedBytes = 0;
+};
+
+// Never destroyed, event buffers of other static objects may still be freed after this file's statics are gone
+static ArenaState &arena() {
+    static ArenaState *state = new ArenaState();
+    return *state;
+}
+
+static size_t roundToHugePages(size_t bytes) {
+    return (bytes + EventArena::HUGE_PAGE_BYTES - 1) / EventArena::HUGE_PAGE_BYTES * EventArena::HUGE_PAGE_BYTES;
+}
+
+#ifdef _WIN32
+
+// Large pages need SeLockMemoryPrivilege held by the account and enabled in the process token
+static bool enableLargePages() {
+    SIZE_T minimum = GetLargePageMinimum();
+    if (minimum == 0 || EventArena::HUGE_PAGE_BYTES % minimum != 0) {
+        return false;
+    }
+
+    HANDLE token;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) {
+        return false;
+    }
+    TOKEN_PRIVILEGES privileges{};
+    privileges.PrivilegeCount = 1;
+    privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    bool enabled = LookupPrivilegeValueA(nullptr, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid)
+        && AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr)
+        && GetLastError() == ERROR_SUCCESS; // ERROR_NOT_ALL_ASSIGNED if the account lacks it
+    CloseHandle(token);
+    return enabled;
+}
+
+static void *mapBlock(size_t bytes) {
+    static const bool largePages = enableLargePages();
+    if (largePages) {
+        // Committed and resident right away, so it never page faults; fails once physical memory is fragmented
+        void *block = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (block != nullptr) {
+            return block;
+        }
+    }
+    return VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+static void unmapBlock(void *block, size_t bytes) {
+    VirtualFree(block, 0, MEM_RELEASE);
+}
+
+#else
+
+static void *mapBlock(size_t bytes) {
+    // Over-map by one huge page and cut off both ends, transparent huge pages only back 2 MB aligned ranges
+    const size_t mapped = bytes + EventArena::HUGE_PAGE_BYTES;
+    void *region = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        return nullptr;
+    }
+
+    const uintptr_t start = reinterpret_cast<uintptr_t>(region);
+    const uintptr_t aligned = (start + EventArena::HUGE_PAGE_BYTES - 1) & ~static_cast<uintptr_t>(EventArena::HUGE_PAGE_BYTES - 1);
+    if (aligned > start) {
+        munmap(region, aligned - start);
+    }
+    const size_t tail = start + mapped - (aligned + bytes);
+    if (tail > 0) {
+        munmap(reinterpret_cast<void *>(aligned + bytes), tail);
+    }
+
+    #ifdef MADV_HUGEPAGE
+        madvise(reinterpret_cast<void *>(aligned), bytes, MADV_HUGEPAGE);
+    #endif
+    return reinterpret_cast<void *>(aligned);
+}
+
+static void unmapBlock(void *block, size_t bytes) {
+    munmap(block, bytes);
+}
+
+#endif
+
+void *EventArena::allocate(size_t bytes) {
+    if (bytes < LARGE_BYTES) {
+        return ::operator new(bytes);
+    }
+
+    const size_t size = roundToHugePages(bytes);
+    {
+        ArenaState &state = arena();
+        std::lock_guard<std::mutex> lock(state.mutex);
+
+        // Smallest cached block that fits, unless it would be more than half unused
+        auto cached = state.cachedBlocks.lower_bound(size);
+        if (cached != state.cachedBlocks.end() && cached->first / 2 <= size) {
+            void *block = cached->second;
+            state.cachedBytes -= cached->first;
+            state.usedBlocks.emplace(block, cached->first);
+            state.cachedBlocks.erase(cached);
+            return block;
+        }
+    }
+
+    void *block = mapBlock(size);
+    if (block == nullptr) {
+        // Cached blocks too small to reuse may be what stands in the way
+        trim();
+        block = mapBlock(size);
+        if (block == nullptr) {
+            throw std::bad_alloc();
+        }
+    }
+
+    ArenaState &state = arena();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.usedBlocks.emplace(block, size);
+    return block;
+}
+
+void EventArena::deallocate(void *ptr, size_t bytes) {
+    if (bytes < LARGE_BYTES) {
+        ::operator delete(ptr);
+        return;
+    }
+
+    size_t size;
+    {
+        ArenaState &state = arena();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        auto used = state.usedBlocks.find(ptr);
+        size = used->second;
+        state.usedBlocks.erase(used);
+
+        if (state.cachedBytes + size <= (static_cast<size_t>(std::max(cacheLimit_MB, 0)) << 20)) {
+            state.cachedBlocks.emplace(size, ptr);
+            state.cachedBytes += size;
+            return;
+        }
+    }
+    unmapBlock(ptr, size);
+}
+
+void EventArena::trim() {
+    std::multimap<size_t, void *> blocks;
+    {
+        ArenaState &state = arena();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        blocks.swap(state.cachedBlocks);
+        state.cachedBytes = 0;
+    }
+    for (const auto &[size, block] : blocks) {
+        unmapBlock(block, size);
+    }
+}
+
+size_t EventArena::getCachedBytes() {
+    ArenaState &state = arena();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.cachedBytes;
+}
@@ -0,0 +1,126 @@
+#include "EventBuffers.h"
+
+#include <algorithm>
+#include <cstdint>
+
+// Binding points of the SSBOs, must match phong_inst.vsh
+static const GLuint POLARITY_BINDING = 0;
+static const GLuint CHUNK_BASE_BINDING = 1;
+
+static void growBuffer(GLenum target, GLuint &buffer, size_t newBytes, size_t keepBytes) {
+    GLuint newBuffer;
+    glGenBuffers(1, &newBuffer);
+    glBindBuffer(target, newBuffer);
+    glBufferData(target, newBytes, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(target, 0);
+
+    if (buffer) {
+        if (keepBytes > 0) {
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, keepBytes);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &buffer);
+    }
+    buffer = newBuffer;
+}
+
+void EventBuffers::reserve(size_t events) {
+    if (events <= capacity && xVBO) {
+        return;
+    }
+
+    // Always at least one chunk, an empty SSBO cannot be bound
+    size_t newCapacity = std::max({events, capacity * 2, EventColumns::CHUNK_EVENTS});
+    growBuffer(GL_ARRAY_BUFFER, xVBO, newCapacity * sizeof(uint16_t), count * sizeof(uint16_t));
+    growBuffer(GL_ARRAY_BUFFER, yVBO, newCapacity * sizeof(uint16_t), count * sizeof(uint16_t));
+    growBuffer(GL_ARRAY_BUFFER, dtVBO, newCapacity * sizeof(uint32_t), count * sizeof(uint32_t));
+    growBuffer(GL_SHADER_STORAGE_BUFFER, polaritySSBO, EventColumns::wordsFor(newCapacity) * sizeof(uint64_t),
+        EventColumns::wordsFor(count) * sizeof(uint64_t));
+    growBuffer(GL_SHADER_STORAGE_BUFFER, chunkBaseSSBO, EventColumns::chunksFor(newCapacity) * sizeof(int64_t),
+        EventColumns::chunksFor(count) * sizeof(int64_t));
+    capacity = newCapacity;
+}
+
+void EventBuffers::upload(const EventColumnsView &events, size_t at) {
+    // Grow geometrically and copy on the GPU, so streaming n events costs O(n) uploads instead of O(n^2)
+    count = std::min(at, count);
+    reserve(at + events.size());
+    count = at + events.size();
+    if (events.empty()) {
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, xVBO);
+    glBufferSubData(GL_ARRAY_BUFFER, at * sizeof(uint16_t), events.size() * sizeof(uint16_t), events.x.data());
+    glBindBuffer(GL_ARRAY_BUFFER, yVBO);
+    glBufferSubData(GL_ARRAY_BUFFER, at * sizeof(uint16_t), events.size() * sizeof(uint16_t), events.y.data());
+    glBindBuffer(GL_ARRAY_BUFFER, dtVBO);
+    glBufferSubData(GL_ARRAY_BUFFER, at * sizeof(uint32_t), events.size() * sizeof(uint32_t), events.dt.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, polaritySSBO);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, (at / 64) * sizeof(uint64_t),
+        EventColumns::wordsFor(events.size()) * sizeof(uint64_t), events.polarityBits + events.origin / 64);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, chunkBaseSSBO);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, (at / EventColumns::CHUNK_EVENTS) * sizeof(int64_t),
+        EventColumns::chunksFor(events.size()) * sizeof(int64_t), events.chunkBase + events.origin / EventColumns::CHUNK_EVENTS);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void EventBuffers::assign(const EventColumnsView &events) {
+    release();
+    upload(events, 0);
+}
+
+void EventBuffers::release() {
+    GLuint buffers[] = {xVBO, yVBO, dtVBO, polaritySSBO, chunkBaseSSBO};
+    if (xVBO) {
+        glDeleteBuffers(5, buffers);
+    }
+    xVBO = yVBO = dtVBO = polaritySSBO = chunkBaseSSBO = 0;
+    count = 0;
+    capacity = 0;
+}
+
+static bool bindColumn(GLint attribute, GLuint vbo, GLenum type) {
+    if (attribute < 0) {
+        return false;
+    }
+
+    // Integer columns are converted to float (not normalized) by the attribute fetch
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glEnableVertexAttribArray(attribute);
+    glVertexAttribPointer(attribute, 1, type, GL_FALSE, 0, nullptr);
+    glVertexAttribDivisor(attribute, 1); // Update once per instance (not per vertex)
+    return true;
+}
+
+bool EventBuffers::bind(const Program &progInst) const {
+    if (!xVBO) {
+        return false;
+    }
+
+    bool ok = bindColumn(progInst.getAttribute("aInstX"), xVBO, GL_UNSIGNED_SHORT);
+    ok = bindColumn(progInst.getAttribute("aInstY"), yVBO, GL_UNSIGNED_SHORT) && ok;
+    ok = bindColumn(progInst.getAttribute("aInstDt"), dtVBO, GL_UNSIGNED_INT) && ok;
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, POLARITY_BINDING, polaritySSBO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CHUNK_BASE_BINDING, chunkBaseSSBO);
+    return ok;
+}
+
+void EventBuffers::unbind(const Program &progInst) const {
+    for (const char *name : {"aInstX", "aInstY", "aInstDt"}) {
+        GLint attribute = progInst.getAttribute(name);
+        if (attribute >= 0) {
+            glDisableVertexAttribArray(attribute);
+            glVertexAttribDivisor(attribute, 0);
+        }
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, POLARITY_BINDING, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CHUNK_BASE_BINDING, 0);
+}
@@ -0,0 +1,288 @@
+#include "EventCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static const size_t CHECKSUM_CHUNK_BYTES = 64 * 1024;
+static const size_t CHECKSUM_CHUNK_COUNT = 64;
+static const size_t COPY_BUFFER_BYTES = 1 << 20;
+
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t bytes) {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < bytes; i++) {
+        hash ^= p[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::string EventCache::cachePathFor(const std::string &recording) {
+    return recording + ".novacache";
+}
+
+uint64_t EventCache::sourceChecksum(const std::string &recording) {
+    std::error_code ec;
+    uint64_t fileSize = fs::file_size(recording, ec);
+    if (ec) {
+        return 0;
+    }
+    auto mtime = fs::last_write_time(recording, ec).time_since_epoch().count();
+    if (ec) {
+        return 0;
+    }
+
+    uint64_t hash = 14695981039346656037ULL;
+    hash = fnv1a(hash, &fileSize, sizeof(fileSize));
+    hash = fnv1a(hash, &mtime, sizeof(mtime));
+
+    // Evenly spaced chunks, always including the very start (header) and the very end (data table) of the file
+    std::ifstream in(recording, std::ios::binary);
+    if (!in) {
+        return 0;
+    }
+
+    std::vector<char> chunk(CHECKSUM_CHUNK_BYTES);
+    uint64_t span = fileSize > CHECKSUM_CHUNK_BYTES ? fileSize - CHECKSUM_CHUNK_BYTES : 0;
+    for (size_t i = 0; i < CHECKSUM_CHUNK_COUNT; i++) {
+        uint64_t offset = span * i / (CHECKSUM_CHUNK_COUNT - 1);
+        in.seekg(static_cast<std::streamoff>(offset));
+        in.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        hash = fnv1a(hash, chunk.data(), static_cast<size_t>(in.gcount()));
+        in.clear();
+
+        if (span == 0) {
+            break;
+        }
+    }
+
+    return hash;
+}
+
+void EventCache::setOptions(EventCacheHeader &header, const LoadOptions &options) {
+    header.decimationType = options.decimationType;
+    header.modFreq = options.modFreq;
+    header.packetStride = options.packetStride;
+    header.keep_ms = options.keep_ms;
+    header.period_ms = options.period_ms;
+    header.polarity = options.polarity;
+    header.roi[0] = static_cast<uint16_t>(options.roiMinX);
+    header.roi[1] = static_cast<uint16_t>(options.roiMinY);
+    header.roi[2] = static_cast<uint16_t>(options.roiMaxX);
+    header.roi[3] = static_cast<uint16_t>(options.roiMaxY);
+    header.roiEnabled = options.roiEnabled ? 1 : 0;
+}
+
+LoadOptions EventCache::getOptions(const EventCacheHeader &header) {
+    LoadOptions options;
+    options.decimationType = header.decimationType;
+    options.modFreq = header.modFreq;
+    options.packetStride = header.packetStride;
+    options.keep_ms = header.keep_ms;
+    options.period_ms = header.period_ms;
+    options.polarity = header.polarity;
+    options.roiMinX = header.roi[0];
+    options.roiMinY = header.roi[1];
+    options.roiMaxX = header.roi[2];
+    options.roiMaxY = header.roi[3];
+    options.roiEnabled = header.roiEnabled != 0;
+    return options;
+}
+
+bool EventCache::open(const std::string &recording, const LoadOptions &options) {
+    if (!mapping.open(cachePathFor(recording))) {
+        return false;
+    }
+
+    bool valid = mapping.size() >= sizeof(EventCacheHeader);
+    if (valid) {
+        const EventCacheHeader &header = getHeader();
+        valid = std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0
+            && header.version == VERSION
+            && getOptions(header).selectsSameEvents(options)
+            && mapping.size() == EventColumnsLayout::of(header.eventCount, sizeof(EventCacheHeader)).end
+            && header.sourceChecksum == sourceChecksum(recording);
+    }
+
+    if (!valid) {
+        mapping.close();
+    }
+    return valid;
+}
+
+EventColumnsView EventCache::getEvents() const {
+    size_t count = static_cast<size_t>(getHeader().eventCount);
+    EventColumnsLayout layout = EventColumnsLayout::of(count, sizeof(EventCacheHeader));
+
+    EventColumnsView events;
+    events.x = std::span<const uint16_t>(reinterpret_cast<const uint16_t *>(mapping.data() + layout.x), count);
+    events.y = std::span<const uint16_t>(reinterpret_cast<const uint16_t *>(mapping.data() + layout.y), count);
+    events.dt = std::span<const uint32_t>(reinterpret_cast<const uint32_t *>(mapping.data() + layout.dt), count);
+    events.polarityBits = reinterpret_cast<const uint64_t *>(mapping.data() + layout.polarity);
+    events.chunkBase = reinterpret_cast<const int64_t *>(mapping.data() + layout.chunkBase);
+    return events;
+}
+
+// Temporary column files, in payload order after x
+static const char *const SIDE_COLUMNS[] = {"y", "dt", "polarity", "chunkBase"};
+
+static std::string columnPath(const std::string &tmpPath, const char *column) {
+    return tmpPath + "." + column;
+}
+
+bool EventCacheWriter::begin(const std::string &recording) {
+    abort();
+
+    finalPath = EventCache::cachePathFor(recording);
+    tmpPath = finalPath + ".tmp";
+    eventCount = 0;
+    polarityWord = 0;
+    chunkBase = 0;
+
+    file = std::fopen(tmpPath.c_str(), "wb");
+    yFile = std::fopen(columnPath(tmpPath, "y").c_str(), "wb");
+    dtFile = std::fopen(columnPath(tmpPath, "dt").c_str(), "wb");
+    polarityFile = std::fopen(columnPath(tmpPath, "polarity").c_str(), "wb");
+    chunkFile = std::fopen(columnPath(tmpPath, "chunkBase").c_str(), "wb");
+    if (!file || !yFile || !dtFile || !polarityFile || !chunkFile) {
+        abort();
+        return false;
+    }
+
+    // Placeholder, overwritten by finish()
+    EventCacheHeader header{};
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+        abort();
+        return false;
+    }
+    return true;
+}
+
+void EventCacheWriter::append(const EventColumnsView &events) {
+    if (!file || events.empty()) {
+        return;
+    }
+
+    /*
+        Whole polarity words are written as they fill up, the last partial one is kept for the next append / finish.
+        Chunks are counted from the start of the file, not of events, so times are rebased whenever the two differ.
+    */
+    std::vector<uint64_t> words;
+    std::vector<uint32_t> dt(events.size());
+    std::vector<int64_t> bases;
+    words.reserve(EventColumns::wordsFor(events.size()) + 1);
+    bases.reserve(EventColumns::chunksFor(events.size()) + 1);
+    for (size_t i = 0; i < events.size(); i++) {
+        uint64_t index = eventCount + i;
+        uint64_t bit = index & 63;
+        polarityWord |= static_cast<uint64_t>(events.getPolarity(i) != 0.0f) << bit;
+        if (bit == 63) {
+            words.push_back(polarityWord);
+            polarityWord = 0;
+        }
+
+        int64_t timestamp = events.getTimestamp(i);
+        if (index % EventColumns::CHUNK_EVENTS == 0) {
+            chunkBase = timestamp;
+            bases.push_back(chunkBase);
+        }
+        dt[i] = static_cast<uint32_t>(std::min<int64_t>(timestamp - chunkBase, UINT32_MAX));
+    }
+
+    bool ok = std::fwrite(events.x.data(), sizeof(uint16_t), events.size(), file) == events.size()
+        && std::fwrite(events.y.data(), sizeof(uint16_t), events.size(), yFile) == events.size()
+        && std::fwrite(dt.data(), sizeof(uint32_t), dt.size(), dtFile) == dt.size()
+        && std::fwrite(words.data(), sizeof(uint64_t), words.size(), polarityFile) == words.size()
+        && std::fwrite(bases.data(), sizeof(int64_t), bases.size(), chunkFile) == bases.size();
+    if (!ok) {
+        abort(); // e.g. disk full, the load itself still succeeds
+        return;
+    }
+    eventCount += events.size();
+}
+
+/*
+    Appends the whole content of the file at path to out, then deletes it.
+*/
+static bool appendFile(std::FILE *out, const std::string &path) {
+    std::FILE *in = std::fopen(path.c_str(), "rb");
+    if (!in) {
+        return false;
+    }
+
+    std::vector<char> buffer(COPY_BUFFER_BYTES);
+    bool ok = true;
+    size_t n;
+    while (ok && (n = std::fread(buffer.data(), 1, buffer.size(), in)) > 0) {
+        ok = std::fwrite(buffer.data(), 1, n, out) == n;
+    }
+    ok = !std::ferror(in) && ok;
+    std::fclose(in);
+
+    std::error_code ec;
+    fs::remove(path, ec);
+    return ok;
+}
+
+void EventCacheWriter::finish(EventCacheHeader header) {
+    if (!file) {
+        return;
+    }
+
+    std::memcpy(header.magic, EventCache::MAGIC, sizeof(EventCache::MAGIC));
+    header.version = EventCache::VERSION;
+    header.eventCount = eventCount;
+
+    bool ok = true;
+    if (eventCount & 63) {
+        ok = std::fwrite(&polarityWord, sizeof(polarityWord), 1, polarityFile) == 1;
+    }
+
+    // Close the column files and concatenate them behind x
+    for (std::FILE **column : {&yFile, &dtFile, &polarityFile, &chunkFile}) {
+        ok = (std::fclose(*column) == 0) && ok;
+        *column = nullptr;
+    }
+    for (const char *column : SIDE_COLUMNS) {
+        ok = ok && appendFile(file, columnPath(tmpPath, column));
+    }
+
+    ok = ok && std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = (std::fclose(file) == 0) && ok;
+    file = nullptr;
+
+    std::error_code ec;
+    if (ok) {
+        fs::rename(tmpPath, finalPath, ec);
+    }
+    if (!ok || ec) {
+        fs::remove(tmpPath, ec);
+    }
+    for (const char *column : SIDE_COLUMNS) {
+        fs::remove(columnPath(tmpPath, column), ec);
+    }
+}
+
+void EventCacheWriter::abort() {
+    if (!file && !yFile && !dtFile && !polarityFile && !chunkFile) {
+        return;
+    }
+
+    for (std::FILE **column : {&file, &yFile, &dtFile, &polarityFile, &chunkFile}) {
+        if (*column) {
+            std::fclose(*column);
+            *column = nullptr;
+        }
+    }
+
+    std::error_code ec;
+    fs::remove(tmpPath, ec);
+    for (const char *column : SIDE_COLUMNS) {
+        fs::remove(columnPath(tmpPath, column), ec);
+    }
+}
@@ -0,0 +1,151 @@
+#include "EventColumns.h"
+
+EventColumnsLayout EventColumnsLayout::of(uint64_t events, uint64_t base) {
+    EventColumnsLayout layout;
+    layout.x = base;
+    layout.y = layout.x + events * sizeof(uint16_t);
+    layout.dt = layout.y + events * sizeof(uint16_t);
+    layout.polarity = layout.dt + events * sizeof(uint32_t);
+    layout.chunkBase = layout.polarity + EventColumns::wordsFor(events) * sizeof(uint64_t);
+    layout.end = layout.chunkBase + EventColumns::chunksFor(events) * sizeof(int64_t);
+    return layout;
+}
+
+int64_t EventColumnsView::getTimestamp(size_t i) const {
+    return chunkBase[(origin + i) / EventColumns::CHUNK_EVENTS] + dt[i];
+}
+
+/*
+    Binary search over the chunk bases first, then over the offsets of the one chunk that can hold the answer. If upper
+    is set it finds the first timestamp > target, otherwise the first >= target.
+*/
+static size_t searchTimestamp(const EventColumnsView &view, int64_t target, bool upper) {
+    if (view.empty()) {
+        return 0;
+    }
+
+    auto before = [&](int64_t timestamp) { return upper ? timestamp <= target : timestamp < target; };
+
+    // Chunks fully or partially covered by the view
+    const size_t CHUNK = EventColumns::CHUNK_EVENTS;
+    size_t firstChunk = view.origin / CHUNK;
+    size_t lastChunk = (view.origin + view.size() - 1) / CHUNK;
+
+    // Last chunk whose base is still before target; the answer lies in it or right after it
+    size_t lo = firstChunk, hi = lastChunk + 1;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (before(view.chunkBase[mid])) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    if (lo == firstChunk) {
+        return 0;
+    }
+    size_t chunk = lo - 1;
+
+    // Offsets within the chunk, clipped to the view
+    size_t begin = std::max(chunk * CHUNK, view.origin) - view.origin;
+    size_t end = std::min((chunk + 1) * CHUNK, view.origin + view.size()) - view.origin;
+    int64_t base = view.chunkBase[chunk];
+    auto it = std::partition_point(view.dt.begin() + begin, view.dt.begin() + end,
+        [&](uint32_t offset) { return before(base + offset); });
+    return static_cast<size_t>(it - view.dt.begin());
+}
+
+size_t EventColumnsView::lowerBound(int64_t timestamp) const {
+    return searchTimestamp(*this, timestamp, false);
+}
+
+size_t EventColumnsView::upperBound(int64_t timestamp) const {
+    return searchTimestamp(*this, timestamp, true);
+}
+
+void EventColumns::reserve(size_t events) {
+    x.reserve(events);
+    y.reserve(events);
+    dt.reserve(events);
+    polarityBits.reserve(wordsFor(events));
+    chunkBase.reserve(chunksFor(events));
+}
+
+void EventColumns::presize(size_t events) {
+    clear();
+    if (capacity() < events || capacity() / 2 > events) {
+        release();
+        reserve(events);
+    }
+}
+
+void EventColumns::resize(size_t events) {
+    x.resize(events);
+    y.resize(events);
+    dt.resize(events);
+    polarityBits.resize(wordsFor(events));
+    chunkBase.resize(chunksFor(events));
+
+    // Keep bits past the end zero, push_back / append only ever OR into the last word
+    if (events & 63) {
+        polarityBits.back() &= (uint64_t(1) << (events & 63)) - 1;
+    }
+}
+
+void EventColumns::clear() {
+    x.clear();
+    y.clear();
+    dt.clear();
+    polarityBits.clear();
+    chunkBase.clear();
+}
+
+void EventColumns::release() {
+    ArenaVector<uint16_t>().swap(x);
+    ArenaVector<uint16_t>().swap(y);
+    ArenaVector<uint32_t>().swap(dt);
+    ArenaVector<uint64_t>().swap(polarityBits);
+    ArenaVector<int64_t>().swap(chunkBase);
+}
+
+void EventColumns::append(const EventColumnsView &other) {
+    if (other.empty()) {
+        return;
+    }
+
+    // Geometric, so a store that was not presized still appends in amortized constant time
+    size_t first = size();
+    if (first + other.size() > capacity()) {
+        reserve(std::max(first + other.size(), capacity() * 2));
+    }
+
+    // Both sides starting on a chunk is the common case (whole slices / blocks), plain column copies
+    if (first % CHUNK_EVENTS == 0 && other.origin % CHUNK_EVENTS == 0) {
+        x.insert(x.end(), other.x.begin(), other.x.end());
+        y.insert(y.end(), other.y.begin(), other.y.end());
+        dt.insert(dt.end(), other.dt.begin(), other.dt.end());
+
+        const uint64_t *words = other.polarityBits + other.origin / 64;
+        polarityBits.insert(polarityBits.end(), words, words + wordsFor(other.size()));
+        if (size() & 63) {
+            polarityBits.back() &= (uint64_t(1) << (size() & 63)) - 1;
+        }
+
+        const int64_t *bases = other.chunkBase + other.origin / CHUNK_EVENTS;
+        chunkBase.insert(chunkBase.end(), bases, bases + chunksFor(other.size()));
+        return;
+    }
+
+    for (size_t i = 0; i < other.size(); i++) {
+        push_back(other.x[i], other.y[i], other.getTimestamp(i), other.getPolarity(i) != 0.0f);
+    }
+}
+
+void EventColumns::swap(EventColumns &other) noexcept {
+    x.swap(other.x);
+    y.swap(other.y);
+    dt.swap(other.dt);
+    polarityBits.swap(other.polarityBits);
+    chunkBase.swap(other.chunkBase);
+}
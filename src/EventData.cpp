@@ -1,33 +1,66 @@
 #include "EventData.h"
 #include "utils.h"
+#include "TimeIndex.h"
+#include "EventImporter.h"
+#include "EventSort.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstdio>
+#include <optional>
+#include <type_traits>
 #include <dv-processing/core/utils.hpp>
+#include <dv-processing/io/read_only_file.hpp>
 #include <omp.h>
 #include <windows.h>
 
 using std::vector, std::cout, std::endl;
 
 // do in order of declaration below
-EventData::EventData() : camera_resolution(0.0f), diffScale(0.0f),
+EventData::EventData() : camera_resolution(0.0f), diffScale(0.0f), instFirstBlock(1), instLastBlock(0),
     earliestTimestamp(0), latestTimestamp(0), shutterType(TIME_SHUTTER), 
     timeWindow_L(0.0f), timeWindow_R(0.0f), eventWindow_L(0), eventWindow_R(0),
     timeShutterWindow_L(0.0f), timeShutterWindow_R(0.0f), eventShutterWindow_L(0),
     eventShutterWindow_R(0), spaceWindow(0.0f), minXYZ(std::numeric_limits<float>::max()),
-    maxXYZ(std::numeric_limits<float>::lowest()), center(0.0f), negColor({1.0f, 0.0f, 0.0f}), 
+    maxXYZ(std::numeric_limits<float>::lowest()), center(0.0f), instBase(0), voxelBuiltCount(0),
+    pixelPrefixBuiltCount(0), pixelPrefixBuiltBudget_MB(0), frameCountsEvents(0), frameCounts_L(0), frameCounts_R(-1),
+    pendingMinXYZ(std::numeric_limits<float>::max()), pendingMaxXYZ(std::numeric_limits<float>::lowest()),
+    loading(false), overflowToPaged(false), cancelRequested(false), loadProgress(0.0f), presizeEvents(0), shownModFreq(1),
+    requestedModFreq(1), live(false), liveNext(0), negColor({1.0f, 0.0f, 0.0f}), 
     posColor({0.0f, 1.0f, 0.0f}), isPositiveOnly(false), unitType(1) {}
 
 EventData::~EventData() {
-    if (instVBO) {
-        glDeleteBuffers(1, &instVBO);
-        instVBO = 0;
-    }
+    cancelLoading();
+    stopLiveStream();
 }
 
 void EventData::reset() {
-    // TODO: Do we want to free the memory? Because if we go from like 100'000 particles -> 10 we should. Otherwise, better to keep
+    cancelLoading();
+    stopLiveStream();
+    liveIngest.reset();
+    live = false;
+    liveNext = 0;
+    pendingBatches.clear();
+    pendingMinXYZ = glm::vec3(std::numeric_limits<float>::max());
+    pendingMaxXYZ = glm::vec3(std::numeric_limits<float>::lowest());
+    loadProgress = 0.0f;
+    presizeEvents = 0;
+    pendingTimeBase = PendingTimeBase();
+    fullParticles.release();
+    shownModFreq = 1;
+    requestedModFreq = 1;
+
+    // Capacity is kept for the next load, which reuses or releases it deliberately, see EventColumns::presize
     evtParticles.clear();
+    evtView = {};
+    evtCache.close();
+    pagedStore.close();
+    compressedStore.clear();
+    decodeScratch.release();
+    instFirstBlock = 1;
+    instLastBlock = 0;
+    overflowToPaged = false;
     earliestTimestamp = 0;
     latestTimestamp = 0;
     minXYZ = glm::vec3(std::numeric_limits<float>::max());
@@ -37,101 +70,1191 @@ void EventData::reset() {
     timeWindow_R = -1.0f;
     spaceWindow = glm::vec4(0.0f);
 
-    if (instVBO) {
-        glDeleteBuffers(1, &instVBO);
-        instVBO = 0;
+    instBuffers.release();
+    instBase = 0;
+
+    voxelGrid.clear();
+    voxelBuffers.release();
+    voxelBuiltOptions = VoxelGridOptions();
+    voxelBuiltCount = 0;
+
+    pixelPrefix.clear();
+    pixelPrefixBuiltCount = 0;
+    pixelPrefixBuiltBudget_MB = 0;
+    frameCountsEvents = 0;
+}
+
+// Blocks decoded at once when compressed, 256K events or ~2 MB of columns
+static const size_t DECODE_BATCH_BLOCKS = 64;
+
+template <typename Fn>
+void EventData::forEachSegment(size_t first, size_t last, Fn &&fn) const {
+    if (first > last) {
+        return;
+    }
+
+    if (!compressedStore.empty()) {
+        size_t lastBlock = CompressedEventStore::blockOf(last);
+        for (size_t b = CompressedEventStore::blockOf(first); b <= lastBlock; b += DECODE_BATCH_BLOCKS) {
+            compressedStore.decode(b, std::min(b + DECODE_BATCH_BLOCKS, lastBlock + 1), decodeScratch);
+            size_t batchFirst = CompressedEventStore::blockStart(b);
+            size_t lo = std::max(first, batchFirst);
+            size_t hi = std::min(last, batchFirst + decodeScratch.size() - 1);
+            fn(decodeScratch.view().subview(lo - batchFirst, hi - lo + 1), lo);
+        }
+        return;
+    }
+
+    if (!pagedStore.isOpen()) {
+        fn(evtView.subview(first, last - first + 1), first);
+        return;
+    }
+
+    for (size_t b = PagedEventStore::blockOf(first); b <= PagedEventStore::blockOf(last); b++) {
+        PagedEventStore::Block block = pagedStore.getBlock(b);
+        size_t blockFirst = PagedEventStore::blockStart(b);
+        size_t lo = std::max(first, blockFirst);
+        size_t hi = std::min(last, blockFirst + block->size() - 1);
+        fn(block->view().subview(lo - blockFirst, hi - lo + 1), lo);
     }
 }
 
-void EventData::initInstancing(Program &progInst) {
-    // Generate / initialize a VBO here. GL_STATIC_DRAW may be better, should test
-    genVBO(instVBO, evtParticles.size() * sizeof(glm::vec4), GL_DYNAMIC_DRAW);
-    
-    glBindBuffer(GL_ARRAY_BUFFER, instVBO);
-    GLint aInstPos = progInst.getAttribute("aInstPos");
+void EventData::initInstancing() {
+    // Pass in the existing data; for a cache hit this reads straight out of the file mapping
+    instBuffers.assign(evtView);
+}
 
-    // Update the vertex attribute pointer every 1 * sizeof(glm::vec4) bytes
-    glEnableVertexAttribArray(aInstPos);
-    glVertexAttribPointer(aInstPos, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), nullptr);
-    glVertexAttribDivisor(aInstPos, 1); // Update once per instance (not per vertex)
-    
-    // Pass in the existing data
-    glBufferSubData(GL_ARRAY_BUFFER, 0, evtParticles.size() * sizeof(glm::vec4), evtParticles.data());
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+bool EventData::exportSelection(const std::string &path, EventExporter::Format format) {
+    if (numEvents() == 0) {
+        printf("Export: nothing loaded\n");
+        return false;
+    }
+
+    // Same bounds as drawFrame, whose within_inc truncates the space window to integers
+    size_t first = eventWindow_L;
+    size_t last = std::min<size_t>(eventWindow_R, numEvents() - 1);
+    ExportFilter filter;
+    filter.minX = static_cast<uint16_t>(std::clamp(spaceWindow.w, 0.0f, 65535.0f));
+    filter.maxX = static_cast<uint16_t>(std::clamp(spaceWindow.y, 0.0f, 65535.0f));
+    filter.minY = static_cast<uint16_t>(std::clamp(spaceWindow.x, 0.0f, 65535.0f));
+    filter.maxY = static_cast<uint16_t>(std::clamp(spaceWindow.z, 0.0f, 65535.0f));
+    filter.positiveOnly = isPositiveOnly;
+
+    // Counting first lets binary and NumPy files be mapped at their final size
+    uint64_t selected = 0;
+    forEachSegment(first, last, [&](const EventColumnsView &events, size_t) {
+        selected += EventExporter::count(events, filter);
+    });
+
+    EventExporter exporter;
+    if (!exporter.begin(path, format, filter, selected, camera_resolution)) {
+        return false;
+    }
+
+    bool ok = true;
+    forEachSegment(first, last, [&](const EventColumnsView &events, size_t) {
+        ok = ok && exporter.append(events);
+    });
+    if (!ok || !exporter.finish()) {
+        return false;
+    }
+
+    printf("Exported %llu events to %s\n", static_cast<unsigned long long>(selected), path.c_str());
+    return true;
+}
+
+void EventData::appendInstancing(size_t first) {
+    // Polarity and chunk bases are uploaded whole, so restart at the chunk holding first
+    size_t aligned = first - first % EventColumns::CHUNK_EVENTS;
+    instBuffers.upload(evtView.subview(aligned, evtView.size() - aligned), aligned);
+}
+
+void EventData::updatePagedInstancing() {
+    // Blocks of the current window, at most as many as may be resident
+    size_t firstBlock = PagedEventStore::blockOf(std::min<size_t>(eventWindow_L, pagedStore.size() - 1));
+    size_t lastBlock = PagedEventStore::blockOf(std::min<size_t>(std::max(eventWindow_L, eventWindow_R), pagedStore.size() - 1));
+    lastBlock = std::min(lastBlock, firstBlock + pagedStore.getMaxResidentBlocks() - 1);
+    if (firstBlock == instFirstBlock && lastBlock == instLastBlock) {
+        return;
+    }
+
+    size_t first = PagedEventStore::blockStart(firstBlock);
+    size_t last = std::min(PagedEventStore::blockStart(lastBlock + 1), pagedStore.size()) - 1;
+
+    // Segments are whole blocks here, so each upload starts on a chunk
+    instBuffers.release();
+    instBuffers.reserve(last - first + 1);
+    forEachSegment(first, last, [&](const EventColumnsView &events, size_t segFirst) {
+        instBuffers.upload(events, segFirst - first);
+    });
+
+    instFirstBlock = firstBlock;
+    instLastBlock = lastBlock;
 }
 
 void EventData::initParticlesFromFile(const std::string &filename) {
-    dv::io::MonoCameraRecording reader(filename);
-    camera_resolution = glm::vec2(reader.getEventResolution().value().width, reader.getEventResolution().value().height);
+    // Blocking variant of startStreamingFromFile, the worker is simply joined before returning
+    startStreamingFromFile(filename);
+    if (loaderThread.joinable()) {
+        loaderThread.join();
+    }
+    mergePendingEvents();
+    finishLoading();
+
+    printf("Loaded %zu particles from %s\n", numEvents(), filename.c_str());
+}
 
+void EventData::startStreamingFromFile(const std::string &filename) {
     // If someone calls init again, we should always reset
     reset();
+    loadingFilename = filename;
+    loadingOptions = loadOptions;
+    shownModFreq = loadOptions.effectiveModFreq();
+    requestedModFreq = shownModFreq;
+
+    // The cache holds whole recordings, a time range is always read from the file
+    if (useEventCache && !loadOptions.hasTimeRange() && loadFromCache(filename, loadOptions)) {
+        return;
+    }
+
+    // Raw EVT and CSV files have no header with the time range, it is only known once they are decoded
+    if (EventImporter::canImport(filename)) {
+        loading = true;
+        cancelRequested = false;
+        loaderThread = std::thread(&EventData::importWorker, this, filename, loadOptions);
+        return;
+    }
+
+    auto reader = std::make_unique<dv::io::MonoCameraRecording>(filename);
+    camera_resolution = glm::vec2(reader->getEventResolution().value().width, reader->getEventResolution().value().height);
+
+    /*
+        The scale used to depend on the last event, which meant nothing could be shown until everything was decoded. The
+        file header already knows the time range, so fixing diffScale up front lets every batch be placed as it arrives.
+    */
+    auto [timeLowest, timeHighest] = reader->getTimeRange();
+    if (loadOptions.hasTimeRange()) {
+        // Only the slice is decoded, so it spans the whole scale
+        const int64_t recordingStart = timeLowest;
+        timeLowest = std::clamp(recordingStart + static_cast<int64_t>(loadOptions.rangeStart_s * 1e6), recordingStart, timeHighest);
+        timeHighest = std::clamp(recordingStart + static_cast<int64_t>(loadOptions.rangeEnd_s * 1e6), timeLowest, timeHighest);
+    }
+    earliestTimestamp = timeLowest;
+    latestTimestamp = std::max(timeHighest, timeLowest + 1);
+
+    // TODO: This is arbitrary, we can should define as a constant somewhere
+    this->diffScale = 5000.0f / static_cast<float>(latestTimestamp - earliestTimestamp);
 
-    // https://dv-processing.inivation.com/rel_1_7/reading_data.html#read-events-from-a-file
-    uint counter = 0; // Necessary for modFreq;
-    while (reader.isRunning()) {
-        if (const auto events = reader.getNextEventBatch(); events.has_value()) {
-            for (auto &evt : events.value()) {
-                if (counter++ % modFreq != 0) { continue; } // TODO instead skip batch if possible
+    loading = true;
+    cancelRequested = false;
+    loaderThread = std::thread(&EventData::streamWorker, this, std::move(reader), filename, loadOptions);
+}
+
+/*
+    Keeps source events offset, offset + modFreq, ... in out. Every chunk of out has its own base and polarity words,
+    so chunks are filled in parallel.
+*/
+static void decimateColumns(const EventColumnsView &source, size_t offset, uint32_t modFreq, EventColumns &out) {
+    const size_t count = source.size() > offset ? (source.size() - offset + modFreq - 1) / modFreq : 0;
+    out.presize(count);
+    out.resize(count);
+
+    const size_t CHUNK = EventColumns::CHUNK_EVENTS;
+    const int numChunks = static_cast<int>(EventColumns::chunksFor(count));
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (int c = 0; c < numChunks; c++) {
+        const size_t first = static_cast<size_t>(c) * CHUNK;
+        const size_t last = std::min(first + CHUNK, count);
+        const int64_t base = source.getTimestamp(offset + first * modFreq);
+        out.chunkBase[c] = base;
+
+        for (size_t k = first; k < last; k++) {
+            const size_t i = offset + k * modFreq;
+            out.x[k] = source.x[i];
+            out.y[k] = source.y[i];
+            // Saturates like EventColumns::push_back, a chunk of a sparse recording decimated far can span > 2^32 us
+            out.dt[k] = static_cast<uint32_t>(std::min<int64_t>(source.getTimestamp(i) - base, UINT32_MAX));
+            out.polarityBits[k >> 6] |= static_cast<uint64_t>(source.getPolarity(i) != 0.0f) << (k & 63);
+        }
+    }
+}
+
+/*
+    Keeps the events of source that pass keep(x, y, timestamp, positive), in order. Chunks are counted and then copied
+    in parallel, each to its own slots.
+*/
+template <typename Keep>
+static void filterColumns(const EventColumnsView &source, Keep &&keep, EventColumns &out) {
+    const size_t CHUNK = EventColumns::CHUNK_EVENTS;
+    const int numChunks = static_cast<int>(EventColumns::chunksFor(source.size()));
+    auto passes = [&](size_t i) { return keep(source.x[i], source.y[i], source.getTimestamp(i), source.getPolarity(i) != 0.0f); };
+
+    vector<size_t> offsets(numChunks + 1, 0);
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (int c = 0; c < numChunks; c++) {
+        const size_t last = std::min((c + 1) * CHUNK, source.size());
+        size_t count = 0;
+        for (size_t i = c * CHUNK; i < last; i++) {
+            count += passes(i) ? 1 : 0;
+        }
+        offsets[c + 1] = count;
+    }
+    for (int c = 0; c < numChunks; c++) {
+        offsets[c + 1] += offsets[c];
+    }
+
+    vector<TimedEvent> kept(offsets[numChunks]);
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (int c = 0; c < numChunks; c++) {
+        const size_t last = std::min((c + 1) * CHUNK, source.size());
+        size_t k = offsets[c];
+        for (size_t i = c * CHUNK; i < last; i++) {
+            if (passes(i)) {
+                kept[k++] = { source.getTimestamp(i), source.x[i], source.y[i], source.getPolarity(i) != 0.0f ? 1u : 0u };
+            }
+        }
+    }
+    EventSort::toColumns(kept, out);
+}
+
+bool EventData::loadFromCache(const std::string &filename, const LoadOptions &options) {
+    // Caches of event decimated loads hold every event, the factor is applied below
+    if (!evtCache.open(filename, options) && !evtCache.open(filename, options.fullResolution())) {
+        return false;
+    }
+
+    const EventCacheHeader &header = evtCache.getHeader();
+    camera_resolution = glm::vec2(header.cameraWidth, header.cameraHeight);
+    earliestTimestamp = header.earliestTimestamp;
+    latestTimestamp = header.latestTimestamp;
+    diffScale = header.diffScale;
+    minXYZ = glm::vec3(header.minXYZ[0], header.minXYZ[1], header.minXYZ[2]);
+    maxXYZ = glm::vec3(header.maxXYZ[0], header.maxXYZ[1], header.maxXYZ[2]);
+
+    this->center = 0.5f * (minXYZ + maxXYZ);
+    this->spaceWindow = glm::vec4(minXYZ.y, maxXYZ.x, maxXYZ.y, minXYZ.x);
+    loadProgress = 1.0f;
+
+    // Events are read from the file from here on, nothing for a previous load's capacity to be reused by
+    evtParticles.release();
+    pendingBatches.clear();
+
+    const uint32_t modFreq = options.effectiveModFreq();
+    const bool decimate = modFreq > 1 && EventCache::getOptions(header).effectiveModFreq() == 1;
+    const uint64_t keptCount = decimate ? (header.eventCount + modFreq - 1) / modFreq : header.eventCount;
+
+    // Too large to touch all at once, only keep the blocks around the current window resident
+    size_t budgetBytes = static_cast<size_t>(std::max(residentBudget_MB, 1)) << 20;
+    if (EventColumnsLayout::of(keptCount, 0).end > budgetBytes) {
+        uint64_t eventCount = header.eventCount;
+        evtCache.close();
+
+        // Blocks are paged straight from the file, so every event of it is shown
+        size_t maxResidentBlocks = budgetBytes / PagedEventStore::BLOCK_BYTES;
+        if (pagedStore.open(EventCache::cachePathFor(filename), sizeof(EventCacheHeader), eventCount, maxResidentBlocks)) {
+            printf("Paging %zu particles from %s\n", pagedStore.size(), EventCache::cachePathFor(filename).c_str());
+            shownModFreq = 1;
+            return true;
+        }
+        return false;
+    }
+
+    // The mapping stays open as the source of later decimation factors, see updateDecimation
+    if (decimate) {
+        decimateColumns(evtCache.getEvents(), 0, modFreq, evtParticles);
+        evtView = evtParticles;
+        printf("Kept every %u. of %llu particles from %s\n", modFreq, static_cast<unsigned long long>(header.eventCount),
+            EventCache::cachePathFor(filename).c_str());
+        return true;
+    }
+
+    evtView = evtCache.getEvents();
+
+    printf("Mapped %zu particles from %s\n", evtView.size(), EventCache::cachePathFor(filename).c_str());
+    return true;
+}
+
+// Bounds on the time span each worker decodes at once, see streamWorker
+static const long long MIN_SLICE_US = 100'000;
+static const long long MAX_SLICE_US = 10'000'000;
+
+/**
+ * @brief Half open [start, end) range of recording timestamps.
+ */
+struct TimeRange {
+    long long start;
+    long long end;
+};
+
+/*
+    The event stream's packets in time order, taken from the packet table of the file so nothing is decompressed.
+    Empty if the recording has no usable table.
+*/
+static vector<dv::FileDataDefinition> readPacketTable(const std::string &filename) {
+    vector<dv::FileDataDefinition> packets;
+
+    dv::io::ReadOnlyFile file(filename);
+    const auto &info = file.getFileInfo();
+    for (const auto &stream : info.mStreams) {
+        if (stream.mName != "events") {
+            continue;
+        }
+
+        auto table = info.mPerStreamDataTables.find(stream.mId);
+        if (table != info.mPerStreamDataTables.end()) {
+            packets = table->second.Table;
+        }
+        break;
+    }
+
+    std::sort(packets.begin(), packets.end(), [](const dv::FileDataDefinition &a, const dv::FileDataDefinition &b) {
+        return a.TimestampStart < b.TimestampStart;
+    });
+    return packets;
+}
+
+/*
+    Time ranges the loader has to decode for the given options, each at most sliceUs long. Packet and time decimation
+    work by leaving ranges out entirely, so the packets in the gaps are never read, let alone decompressed.
+*/
+static vector<TimeRange> buildDecodeRanges(const LoadOptions &options, const std::string &filename,
+    const vector<dv::FileDataDefinition> &packets, long long earliestTimestamp, long long latestTimestamp, long long sliceUs) {
+
+    const long long endTimestamp = latestTimestamp + 1;
+    vector<TimeRange> kept;
+
+    if (options.decimationType == LoadOptions::DECIMATE_PACKETS && options.packetStride > 1) {
+        // Packet k covers [start_k, start_k+1) so events sharing a boundary timestamp are never read twice
+        for (size_t k = 0; k < packets.size(); k += options.packetStride) {
+            kept.push_back({ packets[k].TimestampStart, k + 1 < packets.size() ? packets[k + 1].TimestampStart : endTimestamp });
+        }
+        if (packets.empty()) {
+            printf("No packet table in %s, loading without packet decimation\n", filename.c_str());
+        }
+    }
+    else if (options.decimationType == LoadOptions::DECIMATE_TIME && options.keep_ms < options.period_ms) {
+        const long long period = std::max(1LL, static_cast<long long>(options.period_ms * 1000.0f));
+        const long long keep = std::max(1LL, static_cast<long long>(options.keep_ms * 1000.0f));
+        for (long long t = earliestTimestamp; t < endTimestamp; t += period) {
+            kept.push_back({ t, std::min(t + keep, endTimestamp) });
+        }
+    }
+
+    if (kept.empty()) {
+        kept.push_back({ earliestTimestamp, endTimestamp });
+    }
+
+    // Split so the parallel decode has enough independent pieces; packets may reach outside a time range load
+    vector<TimeRange> ranges;
+    for (const TimeRange &range : kept) {
+        const long long end = std::min(range.end, endTimestamp);
+        for (long long t = std::max(range.start, earliestTimestamp); t < end; t += sliceUs) {
+            ranges.push_back({ t, std::min(t + sliceUs, end) });
+        }
+    }
+    return ranges;
+}
 
-                long long evtTimestamp = evt.timestamp();
-                if (evtParticles.empty()) {
-                    earliestTimestamp = evtTimestamp;
+/*
+    Phase one of a load: how many events the ranges hold according to the packet table, without decoding anything.
+    Packets only partly inside a range count in proportion to the overlapping time, which makes the result an estimate
+    (exact is cleared); whole packets are exact. -1 if the table is missing or a packet does not know its event count.
+*/
+static long long countTableEvents(const vector<dv::FileDataDefinition> &packets, const vector<TimeRange> &ranges, bool &exact) {
+    exact = true;
+    if (packets.empty()) {
+        return -1;
+    }
+
+    // Both are in time order, so one sweep over the packets serves all ranges
+    double total = 0.0;
+    size_t first = 0;
+    for (const TimeRange &range : ranges) {
+        while (first < packets.size() && packets[first].TimestampEnd < range.start) {
+            first++;
+        }
+        for (size_t k = first; k < packets.size() && packets[k].TimestampStart < range.end; k++) {
+            const dv::FileDataDefinition &packet = packets[k];
+            if (packet.NumElements < 0) {
+                return -1;
+            }
+
+            long long span = packet.TimestampEnd - packet.TimestampStart + 1;
+            long long overlap = std::min<long long>(packet.TimestampEnd + 1, range.end) - std::max<long long>(packet.TimestampStart, range.start);
+            if (overlap < span) {
+                exact = false;
+            }
+            total += static_cast<double>(packet.NumElements) * static_cast<double>(std::max(overlap, 0LL)) / static_cast<double>(span);
+        }
+    }
+    return std::llround(total);
+}
+
+/**
+ * @brief One time slice of the recording after conversion, owned by exactly one decode task.
+ */
+struct DecodedSlice {
+    dv::EventStore raw;
+    EventColumns events;
+    EventColumns kept; // events decimated for display, when events is the full resolution for the cache
+    glm::vec3 minXYZ;
+    glm::vec3 maxXYZ;
+};
+
+/*
+    Converts raw events to x, y, timestamp, polarity and reduces their bounding box (with scaled t). firstIndex is the index of the first
+    raw event within the whole recording, so modFreq picks the same events as a sequential pass would. Events filter
+    does not keep are dropped right here.
+
+    Packets are not guaranteed to be in time order inside, e.g. in files merged from several sources. The order is
+    checked along the way and a slice that breaks it is sorted; slices themselves are disjoint time ranges, so sorted
+    slices stitch into a sorted recording.
+*/
+static void convertSlice(DecodedSlice &slice, unsigned long long firstIndex, long long earliestTimestamp, float diffScale, uint modFreq,
+    const LoadOptions &filter) {
+    // Filtered slices grow to what passes instead of reserving for everything
+    const bool filtered = filter.hasEventFilter();
+    slice.events.clear();
+    if (!filtered) {
+        slice.events.reserve((slice.raw.size() + modFreq - 1) / modFreq);
+    }
+    slice.minXYZ = glm::vec3(std::numeric_limits<float>::max());
+    slice.maxXYZ = glm::vec3(std::numeric_limits<float>::lowest());
+
+    unsigned long long counter = firstIndex;
+    int64_t previous = std::numeric_limits<int64_t>::min();
+    bool ordered = true;
+    for (const auto &evt : slice.raw) {
+        if (counter++ % modFreq != 0) { continue; }
+        if (filtered && !filter.keepsEvent(evt.x(), evt.y(), evt.polarity())) { continue; }
+
+        ordered = ordered && evt.timestamp() >= previous;
+        previous = evt.timestamp();
+        slice.events.push_back(static_cast<uint16_t>(evt.x()), static_cast<uint16_t>(evt.y()), evt.timestamp(), evt.polarity());
+
+        // We can sort of "normalize" the timestamp to start at 0 this way, only for the bounding box
+        float relativeTimestamp = static_cast<float>(evt.timestamp() - earliestTimestamp) * diffScale;
+
+        // glm::min/max does componentwise; .x = min(.x, candidate_x), .y = min(.y, candidate_y), ... 
+        glm::vec3 evt_xyt(evt.x(), evt.y(), relativeTimestamp);
+        slice.minXYZ = glm::min(slice.minXYZ, evt_xyt);
+        slice.maxXYZ = glm::max(slice.maxXYZ, evt_xyt);
+    }
+
+    if (!ordered) {
+        vector<TimedEvent> unpacked;
+        unpacked.reserve(slice.events.size());
+        counter = firstIndex;
+        for (const auto &evt : slice.raw) {
+            if (counter++ % modFreq != 0) { continue; }
+            if (filtered && !filter.keepsEvent(evt.x(), evt.y(), evt.polarity())) { continue; }
+            unpacked.push_back({ evt.timestamp(), static_cast<uint16_t>(evt.x()), static_cast<uint16_t>(evt.y()), evt.polarity() ? 1u : 0u });
+        }
+        EventSort::sortByTime(unpacked);
+        EventSort::toColumns(unpacked, slice.events);
+    }
+
+    slice.raw = dv::EventStore(); // Drop our reference to the decoded packets as early as possible
+}
+
+void EventData::streamWorker(std::unique_ptr<dv::io::MonoCameraRecording> reader, std::string filename, LoadOptions options) {
+    // Batches are written to the cache as they go by, so a full decode never has to be repeated for this file
+    EventCacheWriter cacheWriter;
+    if (useEventCache && !options.hasTimeRange()) {
+        cacheWriter.begin(filename);
+    }
+    glm::vec3 totalMin(std::numeric_limits<float>::max());
+    glm::vec3 totalMax(std::numeric_limits<float>::lowest());
+
+    /*
+        MonoCameraRecording decompresses inside getNextEventBatch, so a single reader serializes everything. Instead the
+        recording is cut into time slices and every OpenMP thread owns a reader of its own; getEventsTimeRange seeks
+        through the file's packet table, so each thread only reads and decompresses the packets of its slice.
+
+        Slices are handled in waves of a few per thread. Within a wave every slice is decoded, converted and min/max
+        reduced into its own buffer in parallel, then the buffers are stitched back in time order and handed to the
+        render thread, which keeps the progressive display of the sequential loader.
+    */
+    const int numThreads = omp_get_max_threads();
+    const long long duration = latestTimestamp - earliestTimestamp + 1;
+    const long long sliceUs = std::clamp(duration / (numThreads * 32LL), MIN_SLICE_US, MAX_SLICE_US);
+    const int slicesPerWave = numThreads * 4;
+    const uint modFreq = options.effectiveModFreq();
+
+    /*
+        The cache gets every event, so another decimation factor later on needs no decode (see updateDecimation). With
+        filters decimation counts the events that pass them, so it too can only be applied once a slice is converted.
+    */
+    const bool cacheFullResolution = cacheWriter.isOpen() && modFreq > 1;
+    const bool decimateAfter = modFreq > 1 && (cacheFullResolution || options.hasEventFilter());
+    const LoadOptions cacheOptions = cacheFullResolution ? options.fullResolution() : options;
+
+    const vector<dv::FileDataDefinition> packets = readPacketTable(filename);
+    const vector<TimeRange> ranges = buildDecodeRanges(options, filename, packets, earliestTimestamp, latestTimestamp, sliceUs);
+    const long long numSlices = static_cast<long long>(ranges.size());
+
+    vector<std::unique_ptr<dv::io::MonoCameraRecording>> readers(numThreads);
+    readers[0] = std::move(reader);
+
+    /*
+        Past the resident budget the remaining events only go to the cache file, which the render thread then pages
+        from (see streamPendingEvents). Without a cache there is nothing to page from and everything stays in memory.
+    */
+    const size_t budgetEvents = (static_cast<size_t>(std::max(residentBudget_MB, 1)) << 20) / PagedEventStore::BLOCK_BYTES * PagedEventStore::BLOCK_EVENTS;
+    size_t stagedEvents = 0;
+
+    vector<DecodedSlice> slices(slicesPerWave);
+    vector<unsigned long long> sliceFirstIndex(slicesPerWave);
+    vector<unsigned long long> sliceKeptIndex(slicesPerWave);
+    unsigned long long rawCounter = 0; // Necessary for modFreq;
+
+    /*
+        Phase one: size evtParticles once for everything this load keeps (up to the budget if the rest only goes to the
+        cache) instead of letting it double its way up, which peaks at twice the final size and copies it all on the
+        way. The render thread applies it with the first batch, see mergePendingEvents. Without event counts in the
+        packet table it still grows geometrically, and with filters, which the table knows nothing about.
+    */
+    bool exactCount = false;
+    long long tableEvents = countTableEvents(packets, ranges, exactCount);
+    if (tableEvents >= 0 && !options.hasEventFilter()) {
+        size_t expected = (static_cast<size_t>(tableEvents) + modFreq - 1) / modFreq;
+        if (!exactCount) {
+            expected += expected / 64 + EventColumns::CHUNK_EVENTS;
+        }
+        presizeEvents = cacheWriter.isOpen() ? std::min(expected, budgetEvents) : expected;
+    }
+
+    // A time range starts counting where a full load would be at its first event, so modFreq keeps the same events
+    if (options.hasTimeRange()) {
+        TimeIndex index;
+        if (index.open(filename) || index.build(filename, cancelRequested)) {
+            rawCounter = index.countBefore(earliestTimestamp, *readers[0]);
+            const TimeIndex::Entry *entry = index.locate(earliestTimestamp);
+            printf("Loading %s from event %llu of %llu, byte %lld\n", filename.c_str(), rawCounter,
+                static_cast<unsigned long long>(index.getEventCount()), entry != nullptr ? static_cast<long long>(entry->byteOffset) : 0LL);
+        }
+    }
+
+    // Index among the events that pass the filters; the time index only counts raw events, so filtered ranges start at 0
+    unsigned long long keptCounter = options.hasEventFilter() ? 0 : rawCounter;
+
+    for (long long waveStart = 0; waveStart < numSlices && !cancelRequested; waveStart += slicesPerWave) {
+        const int waveSize = static_cast<int>(std::min<long long>(slicesPerWave, numSlices - waveStart));
+
+        #pragma omp parallel for schedule(dynamic, 1) num_threads(numThreads)
+        for (int k = 0; k < waveSize; k++) {
+            auto &threadReader = readers[omp_get_thread_num()];
+            if (!threadReader) {
+                threadReader = std::make_unique<dv::io::MonoCameraRecording>(filename);
+            }
+
+            const TimeRange &range = ranges[waveStart + k];
+            auto events = threadReader->getEventsTimeRange(range.start, range.end);
+            slices[k].raw = events.has_value() ? std::move(*events) : dv::EventStore();
+        }
+
+        // Global index of each slice's first event, cheap and sequential
+        for (int k = 0; k < waveSize; k++) {
+            sliceFirstIndex[k] = rawCounter;
+            rawCounter += slices[k].raw.size();
+        }
+
+        #pragma omp parallel for schedule(dynamic, 1) num_threads(numThreads)
+        for (int k = 0; k < waveSize; k++) {
+            convertSlice(slices[k], sliceFirstIndex[k], earliestTimestamp, diffScale, decimateAfter ? 1 : modFreq, options);
+        }
+
+        if (decimateAfter) {
+            for (int k = 0; k < waveSize; k++) {
+                sliceKeptIndex[k] = keptCounter;
+                keptCounter += slices[k].events.size();
+            }
+
+            #pragma omp parallel for schedule(dynamic, 1) num_threads(numThreads)
+            for (int k = 0; k < waveSize; k++) {
+                decimateColumns(slices[k].events, (modFreq - sliceKeptIndex[k] % modFreq) % modFreq, modFreq, slices[k].kept);
+            }
+        }
+
+        // Stitch in timestamp order
+        glm::vec3 waveMin(std::numeric_limits<float>::max());
+        glm::vec3 waveMax(std::numeric_limits<float>::lowest());
+        size_t waveEvents = 0;
+        for (int k = 0; k < waveSize; k++) {
+            cacheWriter.append(slices[k].events);
+            waveMin = glm::min(waveMin, slices[k].minXYZ);
+            waveMax = glm::max(waveMax, slices[k].maxXYZ);
+            waveEvents += (decimateAfter ? slices[k].kept : slices[k].events).size();
+        }
+        totalMin = glm::min(totalMin, waveMin);
+        totalMax = glm::max(totalMax, waveMax);
+
+        if (cacheWriter.isOpen() && stagedEvents + waveEvents > budgetEvents) {
+            overflowToPaged = true;
+        }
+
+        if (waveEvents > 0 && !overflowToPaged) {
+            stagedEvents += waveEvents;
+            // The slices' columns change hands as they are, the next wave converts into fresh ones
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            for (int k = 0; k < waveSize; k++) {
+                EventColumns &converted = decimateAfter ? slices[k].kept : slices[k].events;
+                if (!converted.empty()) {
+                    pendingBatches.push_back(std::move(converted));
                 }
-                
-                // Assumedly the last event batch and event has the latest timestamp, but not sure - so use max(...)
-                latestTimestamp = std::max(latestTimestamp, evtTimestamp);
-
-                // We can sort of "normalize" the timestamp to start at 0 this way.
-                float relativeTimestamp = static_cast<float>(evtTimestamp - earliestTimestamp);
-                glm::vec4 evt_xytp = glm::vec4(
-                    static_cast<float>(evt.x()),
-                    static_cast<float>(evt.y()),
-                    relativeTimestamp,
-                    static_cast<float>(evt.polarity()) // (float)true == 1.0f, (float)false == 0.0f
-                );
-
-                evtParticles.push_back(evt_xytp);
-
-                // glm::min/max does componentwise; .x = min(.x, candidate_x), .y = min(.y, candidate_y), ... 
-                minXYZ = glm::min(minXYZ, glm::vec3(evt_xytp));
-                maxXYZ = glm::max(maxXYZ, glm::vec3(evt_xytp));
             }
+            pendingMinXYZ = glm::min(pendingMinXYZ, waveMin);
+            pendingMaxXYZ = glm::max(pendingMaxXYZ, waveMax);
         }
+
+        loadProgress = static_cast<float>(waveStart + waveSize) / static_cast<float>(numSlices);
     }
 
-    // TODO: This is arbitrary, we can should define as a constant somewhere
-    // Apply scale
-    this->diffScale = 5000.0f / static_cast<float>(latestTimestamp - earliestTimestamp);
-    for (auto &evt : evtParticles) {
-        evt.z *= diffScale;
+    if (!cancelRequested) {
+        EventCacheHeader header{};
+        EventCache::setOptions(header, cacheOptions);
+        header.sourceChecksum = EventCache::sourceChecksum(filename);
+        header.earliestTimestamp = earliestTimestamp;
+        header.latestTimestamp = latestTimestamp;
+        header.diffScale = diffScale;
+        header.cameraWidth = camera_resolution.x;
+        header.cameraHeight = camera_resolution.y;
+        for (int i = 0; i < 3; i++) {
+            header.minXYZ[i] = totalMin[i];
+            header.maxXYZ[i] = totalMax[i];
+        }
+        cacheWriter.finish(header);
+
+        loadProgress = 1.0f;
+    }
+    else {
+        overflowToPaged = false; // the cache was not finished, keep the in-memory prefix
     }
+    loading = false;
+}
+
+void EventData::importWorker(std::string filename, LoadOptions options) {
+    if (options.decimationType != LoadOptions::DECIMATE_EVENTS) {
+        printf("%s is imported whole, only event decimation applies to it\n", filename.c_str());
+    }
+
+    /*
+        Imports decode whole files, so their filters, the time range included, are applied right after and event
+        decimation after those. As for recordings the cache gets every event that passes the filters, the decimated
+        copy is only made for display.
+    */
+    const bool cache = useEventCache && !options.hasTimeRange();
+    const bool filter = options.hasEventFilter() || options.hasTimeRange();
+    const uint32_t modFreq = options.effectiveModFreq();
+    ImportedEvents imported;
+    if (!EventImporter::import(filename, cache || filter ? 1 : modFreq, cancelRequested, imported)) {
+        loading = false;
+        return;
+    }
+
+    long long earliest = imported.earliestTimestamp;
+    long long latest = imported.latestTimestamp;
+    glm::vec2 minXY = imported.minXY;
+    glm::vec2 maxXY = imported.maxXY;
+    if (filter) {
+        long long first = earliest;
+        long long last = latest;
+        if (options.hasTimeRange()) {
+            first = std::min(earliest + static_cast<long long>(options.rangeStart_s * 1e6), latest);
+            last = std::clamp(earliest + static_cast<long long>(options.rangeEnd_s * 1e6), first, latest);
+        }
+
+        EventColumns kept;
+        filterColumns(imported.events, [&](uint16_t x, uint16_t y, int64_t t, bool positive) {
+            return t >= first && t <= last && options.keepsEvent(x, y, positive);
+        }, kept);
+        imported.events.swap(kept);
+        if (imported.events.empty()) {
+            printf("No events of %s pass the load filters\n", filename.c_str());
+            loading = false;
+            return;
+        }
+
+        // The bounds shrink to the filters instead of being scanned again
+        earliest = first;
+        latest = std::max(last, first + 1);
+        if (options.roiEnabled) {
+            minXY = glm::vec2(std::max<float>(minXY.x, options.roiMinX), std::max<float>(minXY.y, options.roiMinY));
+            maxXY = glm::vec2(std::min<float>(maxXY.x, options.roiMaxX), std::min<float>(maxXY.y, options.roiMaxY));
+        }
+    }
+
+    const float scale = 5000.0f / static_cast<float>(latest - earliest);
+    const glm::vec3 importedMin(minXY.x, minXY.y, 0.0f);
+    const glm::vec3 importedMax(maxXY.x, maxXY.y, static_cast<float>(latest - earliest) * scale);
+
+    // Cached like a decoded recording, so the next load maps it instead of parsing it again
+    if (cache) {
+        EventCacheWriter cacheWriter;
+        if (cacheWriter.begin(filename)) {
+            cacheWriter.append(imported.events);
+
+            EventCacheHeader header{};
+            EventCache::setOptions(header, options.fullResolution());
+            header.sourceChecksum = EventCache::sourceChecksum(filename);
+            header.earliestTimestamp = earliest;
+            header.latestTimestamp = latest;
+            header.diffScale = scale;
+            header.cameraWidth = imported.resolution.x;
+            header.cameraHeight = imported.resolution.y;
+            for (int i = 0; i < 3; i++) {
+                header.minXYZ[i] = importedMin[i];
+                header.maxXYZ[i] = importedMax[i];
+            }
+            cacheWriter.finish(header);
+        }
+    }
+
+    if (modFreq > 1 && (cache || filter)) {
+        EventColumns kept;
+        decimateColumns(imported.events, 0, modFreq, kept);
+        imported.events.swap(kept);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        pendingBatches.push_back(std::move(imported.events));
+        pendingMinXYZ = importedMin;
+        pendingMaxXYZ = importedMax;
+        pendingTimeBase = { true, earliest, latest, imported.resolution };
+    }
+    loadProgress = 1.0f;
+    loading = false;
+}
+
+size_t EventData::mergePendingEvents() {
+    size_t first = evtView.size();
+
+    // Only the list of batches is taken under the lock, they are copied into evtParticles without holding up the worker
+    std::vector<EventColumns> batches;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        if (pendingTimeBase.set) {
+            // Only imports learn their scale this late, before their first and only batch
+            earliestTimestamp = pendingTimeBase.earliestTimestamp;
+            latestTimestamp = pendingTimeBase.latestTimestamp;
+            diffScale = 5000.0f / static_cast<float>(latestTimestamp - earliestTimestamp);
+            camera_resolution = pendingTimeBase.resolution;
+            pendingTimeBase.set = false;
+        }
+
+        if (pendingBatches.empty()) {
+            return first;
+        }
+
+        batches.swap(pendingBatches);
+        minXYZ = glm::min(minXYZ, pendingMinXYZ);
+        maxXYZ = glm::max(maxXYZ, pendingMaxXYZ);
+    }
+
+    // Phase two: the first batch sizes evtParticles for the whole load
+    size_t presize = presizeEvents.exchange(0);
+    if (presize > 0 && evtParticles.empty()) {
+        evtParticles.presize(presize);
+    }
+
+    for (EventColumns &batch : batches) {
+        // Unless it was sized for the whole load, an empty store simply takes over the batch
+        if (evtParticles.empty() && evtParticles.capacity() < batch.size()) {
+            evtParticles.swap(batch);
+        }
+        else {
+            evtParticles.append(batch);
+        }
+    }
+    evtView = evtParticles;
 
-    // Normalize the timestamp of the min/max XYZ for bounding box
-    this->minXYZ.z *= diffScale;
-    this->maxXYZ.z *= diffScale;
     this->center = 0.5f * (minXYZ + maxXYZ);
-    
     this->spaceWindow = glm::vec4(minXYZ.y, maxXYZ.x, maxXYZ.y, minXYZ.x);
 
-    printf("Loaded %zu particles from %s\n", evtParticles.size(), filename.c_str());
+    return first;
+}
+
+bool EventData::streamPendingEvents() {
+    size_t first = mergePendingEvents();
+    if (first == evtView.size()) {
+        if (!loading && loaderThread.joinable()) {
+            return finishLoading();
+        }
+        return false;
+    }
+
+    appendInstancing(first);
+    return true;
+}
+
+bool EventData::finishLoading() {
+    if (loaderThread.joinable()) {
+        loaderThread.join();
+    }
+    if (!overflowToPaged) {
+        return false;
+    }
+    overflowToPaged = false;
+
+    // Drop the in-memory prefix, the finished cache now holds everything
+    releaseResidentStructures();
+    evtParticles.release();
+    evtView = {};
+    if (!loadFromCache(loadingFilename, loadingOptions)) {
+        printf("Could not page %s, its event cache is missing\n", loadingFilename.c_str());
+    }
+    return true;
+}
+
+void EventData::cancelLoading() {
+    cancelRequested = true;
+    if (loaderThread.joinable()) {
+        loaderThread.join();
+    }
+    loading = false;
+}
+
+bool EventData::updateDownsampling() {
+    // The grid is built over the whole recording at once, which is exactly what paging and compression avoid; live
+    // events change every frame
+    if (pagedStore.isOpen() || !compressedStore.empty() || live) {
+        return false;
+    }
+
+    if (loading || (voxelOptions == voxelBuiltOptions && evtView.size() == voxelBuiltCount)) {
+        return false;
+    }
+    voxelBuiltOptions = voxelOptions;
+    voxelBuiltCount = evtView.size();
+
+    if (!voxelOptions.enabled) {
+        bool wasBuilt = !voxelGrid.isEmpty();
+        voxelGrid.clear();
+        return wasBuilt;
+    }
+
+    voxelGrid.build(evtView, camera_resolution, voxelOptions);
+
+    voxelBuffers.assign(voxelGrid.getParticles());
+
+    return true;
+}
+
+bool EventData::updatePixelPrefix() {
+    // Like the voxel grid, built over the whole resident recording at once
+    if (pagedStore.isOpen() || !compressedStore.empty() || live || loading) {
+        return false;
+    }
+
+    if (!usePixelPrefix) {
+        bool wasBuilt = !pixelPrefix.isEmpty();
+        pixelPrefix.clear();
+        pixelPrefixBuiltCount = 0;
+        return wasBuilt;
+    }
+    if (evtView.size() == pixelPrefixBuiltCount && pixelPrefixBudget_MB == pixelPrefixBuiltBudget_MB) {
+        return false;
+    }
+    pixelPrefixBuiltCount = evtView.size();
+    pixelPrefixBuiltBudget_MB = pixelPrefixBudget_MB;
+
+    pixelPrefix.build(evtView, camera_resolution, static_cast<size_t>(std::max(pixelPrefixBudget_MB, 0)) << 20);
+
+    return true;
+}
+
+void EventData::releaseResidentStructures() {
+    voxelGrid.clear();
+    voxelBuffers.release();
+    voxelBuiltCount = SIZE_MAX; // rebuilt by the next updateDownsampling()
+    pixelPrefix.clear();
+    pixelPrefixBuiltCount = SIZE_MAX; // and updatePixelPrefix()
+}
+
+bool EventData::updateCompression() {
+    // Waits for streamPendingEvents() to join the loader, only then has every batch been merged
+    if (!isLoadComplete() || pagedStore.isOpen() || live || compressResident == !compressedStore.empty()) {
+        return false;
+    }
+
+    if (compressResident) {
+        if (evtView.empty()) {
+            return false;
+        }
+        compressedStore.assign(evtView);
+
+        // The GPU keeps its own copy, so the uncompressed events can go
+        releaseResidentStructures();
+        evtParticles.release();
+        evtView = {};
+        evtCache.close();
+
+        printf("Compressed %zu particles to %.1f MB (%.2f bytes per event)\n", compressedStore.size(),
+            compressedStore.getBytes() / 1048576.0, static_cast<double>(compressedStore.getBytes()) / compressedStore.size());
+    }
+    else {
+        compressedStore.decode(0, compressedStore.getBlockCount(), evtParticles);
+        evtView = evtParticles;
+        compressedStore.clear();
+        decodeScratch.release();
+    }
+    return true;
+}
+
+bool EventData::updateDecimation() {
+    // Acts once per change of the factor, so an unavailable source is not looked for every frame
+    const uint32_t modFreq = loadOptions.effectiveModFreq();
+    if (!isLoadComplete() || pagedStore.isOpen() || live || modFreq == requestedModFreq
+        || loadingOptions.decimationType != LoadOptions::DECIMATE_EVENTS) {
+        return false;
+    }
+    requestedModFreq = modFreq;
+    if (modFreq == shownModFreq) {
+        return false;
+    }
+
+    /*
+        Full resolution events to decimate from: the event cache, which holds every event of the recording (mapped
+        again if compression closed it), or, without a cache, the resident events of a load that kept all of them.
+    */
+    EventColumnsView source;
+    bool cached = evtCache.isOpen() && EventCache::getOptions(evtCache.getHeader()).effectiveModFreq() == 1;
+    if (!cached && !evtCache.isOpen() && useEventCache && !loadingOptions.hasTimeRange()) {
+        cached = evtCache.open(loadingFilename, loadingOptions.fullResolution());
+    }
+    if (cached) {
+        source = evtCache.getEvents();
+    }
+    else {
+        if (fullParticles.empty() && shownModFreq == 1 && compressedStore.empty()) {
+            fullParticles.swap(evtParticles);
+            evtView = fullParticles;
+        }
+        source = fullParticles;
+    }
+    if (source.empty()) {
+        printf("Reload to apply an event frequency of %u, the full resolution events of this load are not kept\n", modFreq);
+        return false;
+    }
+
+    if (modFreq == 1) {
+        // Nothing to copy, show the source itself
+        if (cached) {
+            evtParticles.release();
+            evtView = source;
+        }
+        else {
+            evtParticles.swap(fullParticles);
+            fullParticles.release();
+            evtView = evtParticles;
+        }
+    }
+    else {
+        decimateColumns(source, 0, modFreq, evtParticles);
+        evtView = evtParticles;
+    }
+
+    // updateCompression() compresses the new set again if compressResident is on
+    compressedStore.clear();
+    decodeScratch.release();
+    instBuffers.assign(evtView);
+    voxelBuiltCount = SIZE_MAX; // rebuilt by the next updateDownsampling()
+    pixelPrefixBuiltCount = SIZE_MAX; // and updatePixelPrefix()
+    frameCountsEvents = 0; // same indices, other events
+
+    // Time windows stay, the event ones are looked up again
+    if (shutterType == EVENT_SHUTTER) {
+        eventShutterWindow_L = static_cast<uint>(static_cast<uint64_t>(eventShutterWindow_L) * shownModFreq / modFreq);
+        eventShutterWindow_R = static_cast<uint>(static_cast<uint64_t>(eventShutterWindow_R) * shownModFreq / modFreq);
+    }
+    eventWindow_L = getFirstEvent(timeWindow_L);
+    eventWindow_R = getLastEvent(timeWindow_R);
+    if (shutterType == TIME_SHUTTER) {
+        eventShutterWindow_L = getFirstEvent(timeWindow_L + timeShutterWindow_L) - eventWindow_L;
+        eventShutterWindow_R = getLastEvent(timeWindow_L + timeShutterWindow_R) - eventWindow_L;
+    }
+    shownModFreq = modFreq;
+
+    printf("Kept every %u. of %zu particles\n", modFreq, source.size());
+    return true;
+}
+
+bool EventData::startLiveStream(const std::string &host, int port) {
+    reset();
+
+    std::unique_ptr<dv::io::NetworkReader> reader;
+    try {
+        reader = std::make_unique<dv::io::NetworkReader>(host, static_cast<uint16_t>(port));
+    }
+    catch (const std::exception &e) {
+        printf("Could not connect to %s:%d: %s\n", host.c_str(), port, e.what());
+        return false;
+    }
+    if (!reader->isEventStreamAvailable() || !reader->getEventResolution().has_value()) {
+        printf("%s:%d does not serve an event stream\n", host.c_str(), port);
+        return false;
+    }
+    camera_resolution = glm::vec2(reader->getEventResolution().value().width, reader->getEventResolution().value().height);
+
+    // The bounding box is the sensor times the live window, updateLiveWindow() slides the events through it
+    minXYZ = glm::vec3(0.0f);
+    maxXYZ = glm::vec3(camera_resolution.x - 1.0f, camera_resolution.y - 1.0f, 5000.0f);
+    center = 0.5f * (minXYZ + maxXYZ);
+    spaceWindow = glm::vec4(minXYZ.y, maxXYZ.x, maxXYZ.y, minXYZ.x);
+
+    liveIngest = std::make_shared<LiveIngest>();
+    liveIngest->ring.reset(static_cast<size_t>(std::max(liveRingEvents, 1 << 16)));
+    liveNext = 0;
+    live = true;
+    std::thread(&EventData::liveWorker, liveIngest, std::move(reader)).detach();
+
+    printf("Streaming events from %s:%d\n", host.c_str(), port);
+    return true;
+}
+
+void EventData::stopLiveStream() {
+    // A read blocked on a silent socket only returns with the next packet or the disconnect, so the worker is not
+    // waited for; it holds its own reference to liveIngest and frees it and the reader once that read returns
+    if (liveIngest) {
+        liveIngest->stopRequested = true;
+        liveIngest->connected = false;
+    }
+}
+
+void EventData::liveWorker(std::shared_ptr<LiveIngest> ingest, std::unique_ptr<dv::io::NetworkReader> reader) {
+    try {
+        while (!ingest->stopRequested && reader->isRunning()) {
+            std::optional<dv::EventStore> events = reader->getNextEventBatch();
+            if (!events.has_value()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+
+            for (const auto &evt : *events) {
+                ingest->ring.push(static_cast<uint16_t>(evt.x()), static_cast<uint16_t>(evt.y()), evt.timestamp(), evt.polarity());
+            }
+            ingest->ring.publish();
+        }
+    }
+    catch (const std::exception &e) {
+        printf("Live stream ended: %s\n", e.what());
+    }
+    ingest->connected = false;
+}
+
+bool EventData::updateLiveWindow() {
+    if (!live || !liveIngest) {
+        return false;
+    }
+
+    size_t first = evtParticles.size();
+    liveNext = liveIngest->ring.read(liveNext, evtParticles);
+    if (evtParticles.size() == first) {
+        return false;
+    }
+    evtView = evtParticles;
+
+    // Slide the time base, the GPU rebuilds z from it so nothing already uploaded has to change
+    const int64_t windowUs = std::max<int64_t>(std::llround(liveWindow_ms * 1000.0), 1);
+    latestTimestamp = evtView.getTimestamp(evtView.size() - 1);
+    earliestTimestamp = latestTimestamp - windowUs;
+    diffScale = 5000.0f / static_cast<float>(windowUs);
+
+    size_t stale = evtView.lowerBound(earliestTimestamp);
+    if (stale > liveIngest->ring.capacity()) {
+        // Drop events that slid out of the window once they outnumber a full ring; cut on a chunk so it is a plain copy
+        size_t keepFrom = stale - stale % EventColumns::CHUNK_EVENTS;
+        EventColumns kept;
+        kept.append(evtView.subview(keepFrom, evtView.size() - keepFrom));
+        evtParticles.swap(kept);
+        evtView = evtParticles;
+        stale -= keepFrom;
+        instBuffers.assign(evtView);
+    }
+    else {
+        appendInstancing(first);
+    }
+    instBase = stale;
+
+    // First events: show the whole window
+    if (timeWindow_L < 0.0f) {
+        timeWindow_L = 0.0f;
+        timeWindow_R = maxXYZ.z;
+        timeShutterWindow_L = 0.0f;
+        timeShutterWindow_R = maxXYZ.z;
+    }
+
+    // The time windows stay put relative to the sliding base, the event windows follow them
+    eventWindow_L = getFirstEvent(timeWindow_L);
+    eventWindow_R = getLastEvent(timeWindow_R);
+    if (shutterType == TIME_SHUTTER) {
+        eventShutterWindow_L = getFirstEvent(timeWindow_L + timeShutterWindow_L) - eventWindow_L;
+        eventShutterWindow_R = getLastEvent(timeWindow_L + timeShutterWindow_R) - eventWindow_L;
+    }
+
+    return true;
+}
+
+void EventData::continueFrom(const EventData &previous, bool byEvents, float framePeriod_T, uint framePeriod_E) {
+    // Display settings live per recording
+    shutterType = previous.shutterType;
+    isPositiveOnly = previous.isPositiveOnly;
+    unitType = previous.unitType;
+    negColor = previous.negColor;
+    posColor = previous.posColor;
+    spaceWindow = previous.spaceWindow;
+
+    if (numEvents() == 0) {
+        return;
+    }
+    const uint lastEvent = static_cast<uint>(numEvents() - 1);
+
+    // Shutters are offsets from the window start, time ones in the normalized time of their recording
+    const float rescale = diffScale / previous.diffScale;
+    timeShutterWindow_L = previous.timeShutterWindow_L * rescale;
+    timeShutterWindow_R = previous.timeShutterWindow_R * rescale;
+    eventShutterWindow_L = previous.eventShutterWindow_L;
+    eventShutterWindow_R = previous.eventShutterWindow_R;
+
+    if (byEvents) {
+        // Whatever the step overshot the previous recording by is taken from this one
+        uint span = previous.eventWindow_R - previous.eventWindow_L;
+        uint64_t overshoot = static_cast<uint64_t>(previous.eventWindow_L) + framePeriod_E;
+        overshoot -= std::min<uint64_t>(overshoot, previous.numEvents());
+        eventWindow_L = static_cast<uint>(std::min<uint64_t>(overshoot, lastEvent));
+        eventWindow_R = std::min(eventWindow_L + span, lastEvent);
+        timeWindow_L = getTimestamp(eventWindow_L);
+        timeWindow_R = getTimestamp(eventWindow_R);
+    }
+    else {
+        // Continue at the timestamp the window has reached; recordings of one capture simply follow each other
+        int64_t start = previous.earliestTimestamp + std::llround(previous.toElapsedUs(previous.timeWindow_L + framePeriod_T));
+        double span = previous.toElapsedUs(previous.timeWindow_R - previous.timeWindow_L);
+        timeWindow_L = std::clamp(static_cast<float>(start - earliestTimestamp) * diffScale, 0.0f, maxXYZ.z);
+        timeWindow_R = std::min(timeWindow_L + static_cast<float>(span) * diffScale, maxXYZ.z);
+        eventWindow_L = getFirstEvent(timeWindow_L);
+        eventWindow_R = getLastEvent(timeWindow_R);
+    }
+
+    if (shutterType == TIME_SHUTTER) {
+        eventShutterWindow_L = getFirstEvent(timeWindow_L + timeShutterWindow_L) - eventWindow_L;
+        eventShutterWindow_R = getLastEvent(timeWindow_L + timeShutterWindow_R) - eventWindow_L;
+    }
 }
 
 void EventData::initParticlesEmpty() {
     // If someone calls init again, we should always reset
     reset();
 
-    evtParticles.push_back(glm::vec4(0.0f,0.0f,1.0f,0.0f));
-
     earliestTimestamp=1.0f;
     latestTimestamp=1.0f;
 
     // TODO: This is arbitrary, we can should define as a constant somewhere
     // Apply scale
     this->diffScale = 5.0f;
-    for (auto &evt : evtParticles) {
-        evt.z *= diffScale;
-    }
+    evtParticles.push_back(0, 0, earliestTimestamp + 1, false);
+    evtView = evtParticles;
 
     timeWindow_L = 0.0f;
     timeWindow_R = 1.0f;
@@ -243,24 +1366,28 @@ void EventData::draw(MatrixStack &MV, MatrixStack &P, Program &prog,
     float particleScale, const glm::vec3 &lightPos,
     const BPMaterial &lightMat, const Mesh &meshSphere) { 
 
+    // Walks every event, only supported while they are all in memory
+    if (pagedStore.isOpen() || !compressedStore.empty()) {
+        return;
+    }
+
     prog.bind();
     MV.pushMatrix();
-        for (size_t i = 0; i < evtParticles.size(); i++) {
-            if (i % modFreq == 0) {
-                MV.pushMatrix();
-                    MV.translate(evtParticles[i]);
-                    MV.scale(particleScale);
-
-                    glm::vec3 color = glm::vec3(0.0f, 1.0f, 0.0f);
-                    // apply tint if t not in [timeWindow_L, timeWindow_R]
-                    if (i < eventWindow_L || i > eventWindow_R) {
-                        color = glm::vec3(0.5f, 0.5f, 0.5f);
-                    }
+        for (size_t i = 0; i < evtView.size(); i++) {
+            // Already decimated at load, see LoadOptions.h
+            MV.pushMatrix();
+                MV.translate(glm::vec3(evtView.x[i], evtView.y[i], getTimestamp(static_cast<uint>(i))));
+                MV.scale(particleScale);
+
+                glm::vec3 color = glm::vec3(0.0f, 1.0f, 0.0f);
+                // apply tint if t not in [timeWindow_L, timeWindow_R]
+                if (i < eventWindow_L || i > eventWindow_R) {
+                    color = glm::vec3(0.5f, 0.5f, 0.5f);
+                }
 
-                    sendToPhongShader(prog, P, MV, lightPos, color, lightMat);
-                    meshSphere.draw(prog);
-                MV.popMatrix();
-            }
+                sendToPhongShader(prog, P, MV, lightPos, color, lightMat);
+                meshSphere.draw(prog);
+            MV.popMatrix();
         }
         
         drawBoundingBoxWireframe(MV, P, prog);
@@ -271,23 +1398,25 @@ void EventData::draw(MatrixStack &MV, MatrixStack &P, Program &prog,
 void EventData::drawInstanced(MatrixStack &MV, MatrixStack &P, Program &progInst, Program &progBasic,
     float particleScale) {
     
-    if (evtParticles.empty() || modFreq == 0) {
+    if (numEvents() == 0 || loadOptions.modFreq == 0) {
         return;
     }
 
-    size_t instCt = std::max(1ULL, evtParticles.size());
+    // When paged, instBuffers only holds the blocks around the event window
+    if (pagedStore.isOpen()) {
+        updatePagedInstancing();
+    }
+
+    // Draw the downsampled set instead when the voxel grid is active
+    const EventBuffers &buffers = isVoxelGridActive() ? voxelBuffers : instBuffers;
+    size_t instFirst = &buffers == &instBuffers ? std::min(instBase, buffers.size()) : 0;
+    size_t instCt = buffers.size() - instFirst;
 
     // glBindVertexArray(meshSphere.getVAOID());
 
-    glBindBuffer(GL_ARRAY_BUFFER, instVBO);
-    GLint aInstPos = progInst.getAttribute("aInstPos");
-    if (aInstPos >= 0) {
-        glEnableVertexAttribArray(aInstPos);
-        glVertexAttribPointer(aInstPos, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), nullptr);
-        glVertexAttribDivisor(aInstPos, 1);
-    }
-    else {
-        printf("aInstPos not found in shader\n");
+    if (!buffers.bind(progInst)) {
+        printf("aInstX / aInstY / aInstDt not found in shader\n");
+        buffers.unbind(progInst);
         return;
     }
 
@@ -298,6 +1427,10 @@ void EventData::drawInstanced(MatrixStack &MV, MatrixStack &P, Program &progInst
     glUniformMatrix4fv(progInst.getUniform("MV_it"), 1, GL_FALSE, 
                       glm::value_ptr(glm::inverse(glm::transpose(MV.topMatrix()))));
     glUniform1f(progInst.getUniform("particleScale"), particleScale);
+    glUniform2ui(progInst.getUniform("timeOrigin"), static_cast<GLuint>(static_cast<uint64_t>(earliestTimestamp)),
+        static_cast<GLuint>(static_cast<uint64_t>(earliestTimestamp) >> 32));
+    glUniform1f(progInst.getUniform("timeScale"), diffScale);
+    glUniform1ui(progInst.getUniform("instanceBase"), static_cast<GLuint>(instFirst));
     glUniform3fv(progInst.getUniform("negColor"), 1, glm::value_ptr(negColor));
     glUniform3fv(progInst.getUniform("posColor"), 1, glm::value_ptr(posColor));
 
@@ -306,11 +1439,9 @@ void EventData::drawInstanced(MatrixStack &MV, MatrixStack &P, Program &progInst
     glEnable(GL_POINT_SMOOTH);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glDrawArraysInstanced(GL_POINTS, 0, 1, (GLsizei)instCt);
+    glDrawArraysInstancedBaseInstance(GL_POINTS, 0, 1, (GLsizei)instCt, (GLuint)instFirst);
 
-    glDisableVertexAttribArray(aInstPos);
-    glVertexAttribDivisor(aInstPos, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    buffers.unbind(progInst);
     
     progInst.unbind();
     GLSL::checkError();
@@ -321,15 +1452,74 @@ void EventData::drawInstanced(MatrixStack &MV, MatrixStack &P, Program &progInst
     GLSL::checkError();
 }
 
+void EventData::countShutter(int first, int last, bool fromPrefix) {
+    const int width = static_cast<int>(camera_resolution.x);
+    const int height = static_cast<int>(camera_resolution.y);
+    const size_t pixels = static_cast<size_t>(width) * height;
+
+    auto update = [&](int from, int to, bool subtract) {
+        forEachSegment(from, to, [&](const EventColumnsView &events, size_t) {
+            PixelPrefix::addEvents(events, width, height, subtract, framePositive.data(), frameNegative.data());
+        });
+    };
+
+    // Events that would have to be added and removed to get from the counted shutter to this one
+    const bool overlaps = frameCountsEvents == numEvents() && framePositive.size() == pixels
+        && frameCounts_L <= frameCounts_R && first <= last && first <= frameCounts_R && frameCounts_L <= last;
+    const int64_t moved = overlaps
+        ? std::abs(static_cast<int64_t>(first) - frameCounts_L) + std::abs(static_cast<int64_t>(last) - frameCounts_R)
+        : INT64_MAX;
+
+    if (first > last) {
+        framePositive.assign(pixels, 0);
+        frameNegative.assign(pixels, 0);
+    }
+    else if (fromPrefix) {
+        pixelPrefix.count(evtView, first, last, framePositive, frameNegative);
+    }
+    else if (moved < static_cast<int64_t>(last) - first + 1) {
+        if (first > frameCounts_L) {
+            update(frameCounts_L, first - 1, true);
+        }
+        else if (first < frameCounts_L) {
+            update(first, frameCounts_L - 1, false);
+        }
+        if (last > frameCounts_R) {
+            update(frameCounts_R + 1, last, false);
+        }
+        else if (last < frameCounts_R) {
+            update(last + 1, frameCounts_R, true);
+        }
+    }
+    else {
+        framePositive.assign(pixels, 0);
+        frameNegative.assign(pixels, 0);
+        update(first, last, false);
+    }
+
+    frameCountsEvents = live ? 0 : numEvents();
+    frameCounts_L = first;
+    frameCounts_R = last;
+}
+
+// Events a shutter functor weighs at once, small enough for the batch arrays to stay on the stack / in L1
+static const size_t WEIGHT_BATCH = 256;
+
 // I <3 Zelun
 static inline bool within_inc(uint val, uint left, uint right) {
     return left <= val && val <= right;
 }
 
-void EventData::drawFrame(Program &prog, glm::vec2 viewport_resolution, bool morlet, float freq, bool pca) {
+void EventData::drawFrame(Program &prog, Program &progImage, glm::vec2 viewport_resolution, bool morlet, float freq, bool pca,
+    bool accumulationImage) {
     float timeBound_L, timeBound_R; 
     int eventBound_L, eventBound_R;
 
+    // Nothing streamed in yet
+    if (numEvents() == 0) {
+        return;
+    }
+
     // Set up point size
     float aspectWidth = viewport_resolution.x / static_cast<float>(camera_resolution.x); //FIXME change name camera_res
     float aspectHeight = viewport_resolution.y / static_cast<float>(camera_resolution.y);
@@ -350,103 +1540,293 @@ void EventData::drawFrame(Program &prog, glm::vec2 viewport_resolution, bool mor
     eventBound_L = eventWindow_L + eventShutterWindow_L;
     eventBound_R = eventWindow_L + eventShutterWindow_R;
 
+    // Windows may still point past the end while a file is streaming in
+    eventBound_R = std::min(eventBound_R, static_cast<int>(numEvents()) - 1);
+
+    // Lets the paged store read ahead in the direction the window moves
+    pagedStore.setWindow(eventBound_L, std::max(eventBound_L, eventBound_R));
+
     // TODO fixme on god real.
     // TODO critical section iterator and reduce totalSize
-    float rollingX(0), rollingY(0);
-    std::vector<float> total;
+    // Moments of the accumulated positions, enough for the PCA in either mode
+    double rollingX(0), rollingY(0), rollingXX(0), rollingXY(0), rollingYY(0), rollingCount(0);
+    ArenaVector<float> &total = frameTotal;
+    total.clear();
+    frameThreadTotals.resize(omp_get_max_threads());
+
+    /*
+        Accumulation image: instead of one point per event, every thread multiplies the events into a sensor sized image
+        of its own, which are then combined and uploaded as one texture. Per frame cost past the event loop is then
+        bounded by the pixel count. The frame FBO blends with (GL_ONE, GL_ONE_MINUS_SRC_COLOR), which turns a pixel hit
+        by events of color c_i into 1 - (1 - 0.5) * prod(1 - c_i), so the image keeps prod(1 - c_i) and the points'
+        result is reproduced exactly (up to point sizes spilling into neighbouring pixels).
+    */
+    const int imageW = static_cast<int>(camera_resolution.x);
+    const int imageH = static_cast<int>(camera_resolution.y);
+    accumulationImage = accumulationImage && imageW > 0 && imageH > 0;
+    const size_t imagePixels = accumulationImage ? static_cast<size_t>(imageW) * imageH : 0;
+
+    /*
+        With the box shutter every event of a polarity multiplies its pixel by the same factor, so the image only needs
+        every pixel's event counts: from the prefix sums over the resident events (see PixelPrefix.h), or carried over
+        from the previous frame by adding the events that entered the shutter and removing those that left it. Playback
+        then costs the period stepped rather than the shutter length. Live events move within the ring every frame, so
+        their indices cannot be carried over.
+    */
+    const bool boxImage = accumulationImage && !morlet && !isVoxelGridActive();
+    const bool fromPrefix = boxImage && compressedStore.empty() && !pagedStore.isOpen() && !pixelPrefix.isEmpty()
+        && pixelPrefix.getEventCount() == evtView.size() && pixelPrefix.getWidth() == imageW
+        && pixelPrefix.getHeight() == imageH;
+    const bool fromCounts = fromPrefix || (boxImage && incrementalFrames && !live);
+    if (fromCounts) {
+        frameThreadImages.resize(1);
+        frameThreadImages[0].resize(imagePixels);
+    }
+    else if (accumulationImage) {
+        frameThreadImages.resize(omp_get_max_threads());
+        #pragma omp parallel for
+        for (int thread = 0; thread < static_cast<int>(frameThreadImages.size()); thread++) {
+            frameThreadImages[thread].assign(imagePixels, 1.0f);
+        }
+    }
     float f = freq / 1000000 / diffScale; // Not always needed but moved outside of threading to reduce divisions
-    #pragma omp parallel
-    {
-        // Select contribution function
-        std::shared_ptr<BaseFunc> contributionFunc = nullptr;
+
+    // Event times are taken relative to the window center in int64 first, so the float t stays small and exact
+    int64_t centerTimestamp = earliestTimestamp
+        + std::llround(toElapsedUs(timeBound_L + (timeBound_R - timeBound_L) * 0.5f));
+
+    // Accumulates one contiguous span of events with a shutter functor (see ContributionFunc.h), instantiated per
+    // functor type; weights (optional) scales each contribution
+    auto accumulate = [&](const auto &shutter, const EventColumnsView &events, const float *weights) {
+        using Shutter = std::decay_t<decltype(shutter)>;
+        double spanX(0), spanY(0), spanXX(0), spanXY(0), spanYY(0), spanCount(0);
+        #pragma omp parallel
+        {
+            float batchTimes[WEIGHT_BATCH], batchPolarities[WEIGHT_BATCH], batchWeights[WEIGHT_BATCH];
+
+            ArenaVector<float> &localTotal = frameThreadTotals[omp_get_thread_num()];
+            localTotal.clear();
+            float *localImage = accumulationImage ? frameThreadImages[omp_get_thread_num()].data() : nullptr;
+            const int batches = static_cast<int>((events.size() + WEIGHT_BATCH - 1) / WEIGHT_BATCH);
+            #pragma omp for reduction(+ : spanX) reduction(+ : spanY) reduction(+ : spanXX) reduction(+ : spanXY) \
+                reduction(+ : spanYY) reduction(+ : spanCount)
+            for (int batch = 0; batch < batches; ++batch) {
+                const size_t first = static_cast<size_t>(batch) * WEIGHT_BATCH;
+                const size_t count = std::min(WEIGHT_BATCH, events.size() - first);
+                if constexpr (Shutter::USES_TIME) {
+                    for (size_t j = 0; j < count; j++) {
+                        batchTimes[j] = static_cast<float>(events.getTimestamp(first + j) - centerTimestamp) * diffScale;
+                    }
+                }
+                for (size_t j = 0; j < count; j++) {
+                    batchPolarities[j] = events.getPolarity(first + j) != 0.0f ? 1.0f : -1.0f;
+                }
+                shutter.getWeights(batchTimes, batchPolarities, count, batchWeights);
+
+                for (size_t j = 0; j < count; j++) {
+                    const size_t i = first + j;
+                    float x(events.x[i]), y(events.y[i]);
+
+                    if (batchPolarities[j] > 0.0f || not isPositiveOnly) {
+                        if (within_inc(x, spaceWindow.w, spaceWindow.y) && within_inc(y, spaceWindow.x, spaceWindow.z)) {
+                            float weight = weights ? weights[i] * batchWeights[j] : batchWeights[j];
+                            if (localImage) {
+                                // Same color as basic.fsh gives the point
+                                if (events.x[i] < imageW && events.y[i] < imageH) {
+                                    localImage[static_cast<size_t>(events.y[i]) * imageW + events.x[i]] *= 1.0f - (weight < 0.0f ? 0.25f * weight : weight);
+                                }
+                            }
+                            else {
+                                localTotal.push_back(x);
+                                localTotal.push_back(y);
+                                localTotal.push_back(weight);
+                            }
+
+                            spanX += x;
+                            spanY += y;
+                            spanXX += x * x;
+                            spanXY += x * y;
+                            spanYY += y * y;
+                            spanCount += 1.0;
+                        }
+                    }
+                }
+            }
+
+            #pragma omp critical
+            {
+                total.insert(total.end(), std::make_move_iterator(localTotal.begin()), std::make_move_iterator(localTotal.end()));
+            }
+        }
+        rollingX += spanX;
+        rollingY += spanY;
+        rollingXX += spanXX;
+        rollingXY += spanXY;
+        rollingYY += spanYY;
+        rollingCount += spanCount;
+    };
+
+    if (fromCounts) {
+        countShutter(eventBound_L, eventBound_R, fromPrefix);
+
+        // Every event of a polarity multiplies its pixel by the same factor, the one accumulate() would apply
+        const float polarities[2] = { 1.0f, -1.0f };
+        float polarityWeights[2];
+        BoxShutter().getWeights(nullptr, polarities, 2, polarityWeights);
+        const float positiveFactor = 1.0f - (polarityWeights[0] < 0.0f ? 0.25f * polarityWeights[0] : polarityWeights[0]);
+        const float negativeFactor = 1.0f - (polarityWeights[1] < 0.0f ? 0.25f * polarityWeights[1] : polarityWeights[1]);
+
+        float *image = frameThreadImages[0].data();
+        double spanX(0), spanY(0), spanXX(0), spanXY(0), spanYY(0), spanCount(0);
+        #pragma omp parallel for reduction(+ : spanX) reduction(+ : spanY) reduction(+ : spanXX) reduction(+ : spanXY) \
+            reduction(+ : spanYY) reduction(+ : spanCount)
+        for (int p = 0; p < static_cast<int>(imagePixels); p++) {
+            const uint x = p % imageW;
+            const uint y = p / imageW;
+            const uint32_t positive = framePositive[p];
+            const uint32_t negative = isPositiveOnly ? 0 : frameNegative[p];
+            if (!within_inc(x, spaceWindow.w, spaceWindow.y) || !within_inc(y, spaceWindow.x, spaceWindow.z)) {
+                image[p] = 1.0f;
+                continue;
+            }
+            image[p] = std::pow(positiveFactor, static_cast<float>(positive)) * std::pow(negativeFactor, static_cast<float>(negative));
+
+            const double events = static_cast<double>(positive) + negative;
+            spanX += events * x;
+            spanY += events * y;
+            spanXX += events * x * x;
+            spanXY += events * x * y;
+            spanYY += events * y * y;
+            spanCount += events;
+        }
+        rollingX += spanX;
+        rollingY += spanY;
+        rollingXX += spanXX;
+        rollingXY += spanXY;
+        rollingYY += spanYY;
+        rollingCount += spanCount;
+    }
+    else if (eventBound_L <= eventBound_R) {
+        auto accumulateWindow = [&](const auto &shutter) {
+            if (isVoxelGridActive()) {
+                // Same time span of the reduced set, each event scaled by its weight
+                auto [voxel_L, voxel_R] = voxelGrid.getRange(evtView.getTimestamp(eventBound_L), evtView.getTimestamp(eventBound_R));
+                if (voxel_L <= voxel_R) {
+                    accumulate(shutter, voxelGrid.getParticles().subview(voxel_L, voxel_R - voxel_L + 1),
+                        voxelGrid.getWeights().data() + voxel_L);
+                }
+            }
+            else {
+                forEachSegment(eventBound_L, eventBound_R, [&](const EventColumnsView &events, size_t) {
+                    accumulate(shutter, events, nullptr);
+                });
+            }
+        };
+
+        // Select the shutter once per frame
         int choice = morlet ? 1 : 0; // Can be expanded for new contribution functions
         switch (choice) {
             case 0:
-                contributionFunc = std::make_shared<BaseFunc>();
+                accumulateWindow(BoxShutter());
                 break;
 
-            case 1: 
-                float center_t = timeBound_L + (timeBound_R - timeBound_L) * 0.5f;;
-                contributionFunc = std::make_shared<MorletFunc>(f, center_t);
+            case 1:
+                accumulateWindow(MorletShutter(f));
                 break;
         }
+    }
 
-        std::vector<float> localTotal;
-        #pragma omp for reduction(+ : rollingX) reduction(+ : rollingY)
-        for (int i = eventBound_L; i <= eventBound_R; ++i) {
-            float x(evtParticles[i].x), y(evtParticles[i].y), t(evtParticles[i].z);
-            float polarity = evtParticles[i].w;
-
-            contributionFunc->setX(x);
-            contributionFunc->setY(y);
-            contributionFunc->setT(t);
-            contributionFunc->setPolarity(polarity);
-
-            if (polarity == 1 || not isPositiveOnly) {
-                if (within_inc(x, spaceWindow.w, spaceWindow.y) && within_inc(y, spaceWindow.x, spaceWindow.z)) {
-                    localTotal.push_back(x);
-                    localTotal.push_back(y);
-                    localTotal.push_back(contributionFunc->getWeight());
-
-                    rollingX += x;
-                    rollingY += y;
-                }
+    glm::mat4 projection = glm::ortho(minXYZ.x, maxXYZ.x, minXYZ.y, maxXYZ.y);
+    if (accumulationImage) {
+        // Fold the thread images into the first one
+        float *image = frameThreadImages[0].data();
+        #pragma omp parallel for
+        for (int p = 0; p < static_cast<int>(imagePixels); p++) {
+            float remaining = image[p];
+            for (size_t thread = 1; thread < frameThreadImages.size(); thread++) {
+                remaining *= frameThreadImages[thread][p];
             }
+            image[p] = remaining;
         }
 
-        #pragma omp critical
-        {
-            total.insert(total.end(), std::make_move_iterator(localTotal.begin()), std::make_move_iterator(localTotal.end()));
+        static GLuint imageTexture, imageVBO, imageVAO;
+        static int textureW = 0, textureH = 0;
+        if (textureW == 0) {
+            glGenTextures(1, &imageTexture);
+            glGenBuffers(1, &imageVBO);
+            glGenVertexArrays(1, &imageVAO);
+        }
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, imageTexture);
+        if (textureW != imageW || textureH != imageH) {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, imageW, imageH, 0, GL_RED, GL_FLOAT, image);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            textureW = imageW;
+            textureH = imageH;
+        }
+        else {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, imageW, imageH, GL_RED, GL_FLOAT, image);
         }
-    }
 
-    // Load data points
-    glBindVertexArray(VAO); 
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, total.size() * sizeof(float), total.data(), GL_STATIC_DRAW);
+        // The sensor in event coordinates, texel centers land where the points would be drawn
+        const float corners[] = {
+            -0.5f, -0.5f, 0.0f, 0.0f,
+            imageW - 0.5f, -0.5f, 1.0f, 0.0f,
+            imageW - 0.5f, imageH - 0.5f, 1.0f, 1.0f,
+            -0.5f, imageH - 0.5f, 0.0f, 1.0f
+        };
+        glBindVertexArray(imageVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, imageVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_DYNAMIC_DRAW);
 
-    prog.bind();
+        progImage.bind();
 
-    int pos = prog.getAttribute("pos");
-	glEnableVertexAttribArray(pos);
-	glVertexAttribPointer(pos, 3, GL_FLOAT, GL_FALSE, 0, (const void *)0);
-    glVertexAttribDivisor(pos, 1);
+        int corner = progImage.getAttribute("corner");
+        glEnableVertexAttribArray(corner);
+        glVertexAttribPointer(corner, 4, GL_FLOAT, GL_FALSE, 0, (const void *)0);
 
-    glm::mat4 projection = glm::ortho(minXYZ.x, maxXYZ.x, minXYZ.y, maxXYZ.y);
-    glUniformMatrix4fv(prog.getUniform("projection"), 1, GL_FALSE, glm::value_ptr(projection));
-    glDrawArraysInstanced(GL_POINTS, 0, 1, static_cast<GLsizei>(total.size()));
+        glUniformMatrix4fv(progImage.getUniform("projection"), 1, GL_FALSE, glm::value_ptr(projection));
+        glUniform1i(progImage.getUniform("image"), 0);
+        glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
 
-    prog.unbind();
+        progImage.unbind();
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    else {
+        // Load data points
+        glBindVertexArray(VAO); 
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, total.size() * sizeof(float), total.data(), GL_STATIC_DRAW);
+
+        prog.bind();
+
+        int pos = prog.getAttribute("pos");
+        glEnableVertexAttribArray(pos);
+        glVertexAttribPointer(pos, 3, GL_FLOAT, GL_FALSE, 0, (const void *)0);
+        glVertexAttribDivisor(pos, 1);
+
+        glUniformMatrix4fv(prog.getUniform("projection"), 1, GL_FALSE, glm::value_ptr(projection));
+        glDrawArraysInstanced(GL_POINTS, 0, 1, static_cast<GLsizei>(total.size()));
+
+        prog.unbind();
+    }
 
     glBindVertexArray(0);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    if (pca) {
-        // Calculate covariance
+    if (pca && rollingCount > 1.0) {
+        // Calculate covariance, from the moments summed while accumulating
 
-        // TODO: inverse change? (make sure to always update when new files are used)
-        float inverseNumElems = 3.0f / total.size();
-        float mean_x = rollingX * inverseNumElems;
-        float mean_y = rollingY * inverseNumElems;
-        
-        float cov_x_x(0.0f), cov_x_y(0.0f), cov_y_y(0.0f);
-        #pragma omp parallel
-        {
-            #pragma omp for reduction(+ : cov_x_y) reduction(+ : cov_x_x) reduction(+ : cov_y_y)
-            for (int i = 0; i < (int) total.size(); i += 3) {
-                float x = total[i];
-                float y = total[i + 1];
-
-                cov_x_y += (x - mean_x) * (y - mean_y);
-                cov_x_x += (x - mean_x) * (x - mean_x);
-                cov_y_y += (y - mean_y) * (y - mean_y);
-            }
-        }
+        float mean_x = static_cast<float>(rollingX / rollingCount);
+        float mean_y = static_cast<float>(rollingY / rollingCount);
 
-        inverseNumElems = 1.0f / (total.size() / 3.0f - 1);
-        cov_x_y *= inverseNumElems;
-        cov_x_x *= inverseNumElems;
-        cov_y_y *= inverseNumElems;
+        float cov_x_y = static_cast<float>((rollingXY - rollingX * rollingY / rollingCount) / (rollingCount - 1.0));
+        float cov_x_x = static_cast<float>((rollingXX - rollingX * rollingX / rollingCount) / (rollingCount - 1.0));
+        float cov_y_y = static_cast<float>((rollingYY - rollingY * rollingY / rollingCount) / (rollingCount - 1.0));
 
         // Matrix
         float a = 1;
@@ -508,33 +1888,38 @@ void EventData::oddizeTime() {
 }
 
 float EventData::getTimestamp(uint eventIndex, float oddFactor) const {
-    return evtParticles[eventIndex].z / oddFactor;
-}
+    if (numEvents() == 0) {
+        return 0.0f;
+    }
 
-inline bool lessVec4_t(const glm::vec4& a, const glm::vec4& b) {
-    return a.z < b.z;
+    // Can be past the end while a file is still streaming in
+    size_t i = std::min<size_t>(eventIndex, numEvents() - 1);
+    int64_t timestamp = pagedStore.isOpen() ? pagedStore.getTimestamp(i)
+        : !compressedStore.empty() ? compressedStore.getTimestamp(i) : evtView.getTimestamp(i);
+    return static_cast<float>(static_cast<double>(timestamp - earliestTimestamp) * diffScale) / oddFactor;
 }
 
 // If timestamp does not exist return first event included in window
 uint EventData::getFirstEvent(float timestamp, float normFactor) const {
-    assert(this->evtParticles.size() != 0);
-    glm::vec4 timestampVec4(0.0f, 0.0f, timestamp * normFactor, 0.0f); 
-
-    auto lb = std::lower_bound(evtParticles.begin(), evtParticles.end(), timestampVec4, lessVec4_t);
-    if (lb == evtParticles.end()) {
-        return static_cast<uint>(evtParticles.size() - 1);
+    if (numEvents() == 0) {
+        return 0;
     }
-    return std::distance(evtParticles.begin(), lb);
+
+    // Smallest timestamp whose scaled time is >= the requested one; only the time columns are searched
+    int64_t target = earliestTimestamp + static_cast<int64_t>(std::ceil(toElapsedUs(timestamp * normFactor)));
+    size_t lb = pagedStore.isOpen() ? pagedStore.lowerBound(target)
+        : !compressedStore.empty() ? compressedStore.lowerBound(target) : evtView.lowerBound(target);
+    return static_cast<uint>(std::min(lb, numEvents() - 1));
 } 
 
 // If timestamp does not exist return last event included in window
 uint EventData::getLastEvent(float timestamp, float normFactor) const {
-    assert(this->evtParticles.size() != 0);
-    glm::vec4 timestampVec4(0.0f, 0.0f, timestamp * normFactor, 0.0f); 
-
-    auto ub = std::upper_bound(evtParticles.begin(), evtParticles.end(), timestampVec4, lessVec4_t);
-    if (ub == evtParticles.begin()) {
+    if (numEvents() == 0) {
         return 0;
     }
-    return std::distance(evtParticles.begin(), --ub);
+
+    int64_t target = earliestTimestamp + static_cast<int64_t>(std::floor(toElapsedUs(timestamp * normFactor)));
+    size_t ub = pagedStore.isOpen() ? pagedStore.upperBound(target)
+        : !compressedStore.empty() ? compressedStore.upperBound(target) : evtView.upperBound(target);
+    return ub == 0 ? 0 : static_cast<uint>(ub - 1);
 }
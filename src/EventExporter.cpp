@@ -0,0 +1,214 @@
+#include "EventExporter.h"
+
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <vector>
+#include <omp.h>
+
+// Kept events are written at offsets from a prefix over the threads' counts, so records land in file order
+template <typename Write>
+static size_t filterSpan(const EventColumnsView &events, const ExportFilter &filter, size_t capacity, Write &&write) {
+    const int maxThreads = omp_get_max_threads();
+    std::vector<size_t> threadKept(maxThreads + 1, 0);
+    size_t total = 0;
+
+    #pragma omp parallel
+    {
+        const int thread = omp_get_thread_num();
+        const int numThreads = omp_get_num_threads();
+        const size_t begin = events.size() * thread / numThreads;
+        const size_t end = events.size() * (thread + 1) / numThreads;
+
+        size_t kept = 0;
+        for (size_t i = begin; i < end; i++) {
+            kept += filter.keeps(events.x[i], events.y[i], events.getPolarity(i) != 0.0f);
+        }
+        threadKept[thread + 1] = kept;
+
+        #pragma omp barrier
+        #pragma omp single
+        {
+            for (int t = 0; t < numThreads; t++) {
+                threadKept[t + 1] += threadKept[t];
+            }
+            total = threadKept[numThreads];
+        }
+
+        if (total <= capacity) {
+            size_t out = threadKept[thread];
+            for (size_t i = begin; i < end; i++) {
+                bool positive = events.getPolarity(i) != 0.0f;
+                if (filter.keeps(events.x[i], events.y[i], positive)) {
+                    write(out++, events.getTimestamp(i), events.x[i], events.y[i], positive);
+                }
+            }
+        }
+    }
+
+    return total <= capacity ? total : SIZE_MAX;
+}
+
+// Format 1.0: magic, version, uint16 header length, then a dict padded so the data starts 64 byte aligned
+static std::string npyHeader(uint64_t events) {
+    std::string dict = "{'descr': [('t', '<i8'), ('x', '<u2'), ('y', '<u2'), ('p', '<u4')], 'fortran_order': False, "
+        "'shape': (" + std::to_string(events) + ",), }";
+    const size_t preamble = 10;
+    size_t total = (preamble + dict.size() + 1 + 63) / 64 * 64;
+    dict.append(total - preamble - dict.size() - 1, ' ');
+    dict.push_back('\n');
+
+    std::string header("\x93NUMPY\x01\x00", 8);
+    header.push_back(static_cast<char>(dict.size() & 0xFF));
+    header.push_back(static_cast<char>(dict.size() >> 8));
+    return header + dict;
+}
+
+EventExporter::~EventExporter() {
+    abort();
+}
+
+const char *EventExporter::extensionOf(Format format) {
+    switch (format) {
+        case FORMAT_NPY:
+            return ".npy";
+        case FORMAT_AEDAT4:
+            return ".aedat4";
+        default:
+            return ".bin";
+    }
+}
+
+uint64_t EventExporter::count(const EventColumnsView &events, const ExportFilter &filter) {
+    // Per thread slices rather than an int loop, spans of a large resident recording can exceed INT_MAX events
+    std::vector<uint64_t> threadKept(omp_get_max_threads(), 0);
+    #pragma omp parallel
+    {
+        const int thread = omp_get_thread_num();
+        const int numThreads = omp_get_num_threads();
+        const size_t end = events.size() * (thread + 1) / numThreads;
+        uint64_t kept = 0;
+        for (size_t i = events.size() * thread / numThreads; i < end; i++) {
+            kept += filter.keeps(events.x[i], events.y[i], events.getPolarity(i) != 0.0f);
+        }
+        threadKept[thread] = kept;
+    }
+
+    uint64_t kept = 0;
+    for (uint64_t threadCount : threadKept) {
+        kept += threadCount;
+    }
+    return kept;
+}
+
+bool EventExporter::begin(const std::string &path, Format format, const ExportFilter &filter, uint64_t events, glm::vec2 resolution) {
+    abort();
+
+    this->path = path;
+    this->format = format;
+    this->filter = filter;
+    capacity = events;
+    written = 0;
+
+    if (events == 0) {
+        printf("Export: no events selected\n");
+        return false;
+    }
+
+    if (format == FORMAT_AEDAT4) {
+        try {
+            auto config = dv::io::MonoCameraWriter::EventOnlyConfig("NOVA export",
+                cv::Size(static_cast<int>(resolution.x), static_cast<int>(resolution.y)));
+            writer = std::make_unique<dv::io::MonoCameraWriter>(path, config);
+        }
+        catch (const std::exception &e) {
+            printf("Export: cannot create %s: %s\n", path.c_str(), e.what());
+            writer.reset();
+            return false;
+        }
+        return true;
+    }
+
+    const std::string header = format == FORMAT_NPY ? npyHeader(events) : std::string();
+    if (!output.create(path, header.size() + events * sizeof(TimedEvent))) {
+        printf("Export: cannot create %s\n", path.c_str());
+        return false;
+    }
+    std::memcpy(output.writableData(), header.data(), header.size());
+    records = reinterpret_cast<TimedEvent *>(output.writableData() + header.size());
+    return true;
+}
+
+bool EventExporter::append(const EventColumnsView &events) {
+    if (!isOpen() || events.empty()) {
+        return isOpen();
+    }
+
+    size_t kept;
+    if (writer) {
+        dv::EventPacket packet;
+        packet.elements.resize(events.size());
+        kept = filterSpan(events, filter, capacity - written,
+            [&](size_t out, int64_t timestamp, uint16_t x, uint16_t y, bool positive) {
+                packet.elements[out] = dv::Event(timestamp, static_cast<int16_t>(x), static_cast<int16_t>(y), positive);
+            });
+        if (kept != SIZE_MAX && kept > 0) {
+            packet.elements.resize(kept);
+            try {
+                writer->writeEvents(dv::EventStore(packet));
+            }
+            catch (const std::exception &e) {
+                printf("Export: writing %s failed: %s\n", path.c_str(), e.what());
+                abort();
+                return false;
+            }
+        }
+    }
+    else {
+        TimedEvent *out = records + written;
+        kept = filterSpan(events, filter, capacity - written,
+            [out](size_t index, int64_t timestamp, uint16_t x, uint16_t y, bool positive) {
+                out[index] = { timestamp, x, y, static_cast<uint32_t>(positive) };
+            });
+    }
+
+    if (kept == SIZE_MAX) {
+        printf("Export: more events than the %llu announced\n", static_cast<unsigned long long>(capacity));
+        abort();
+        return false;
+    }
+    written += kept;
+    return true;
+}
+
+bool EventExporter::finish() {
+    if (!isOpen()) {
+        return false;
+    }
+    if (written != capacity) {
+        printf("Export: %llu of %llu events written\n", static_cast<unsigned long long>(written),
+            static_cast<unsigned long long>(capacity));
+        abort();
+        return false;
+    }
+
+    // Unmapping / destroying the writer flushes the file
+    output.close();
+    records = nullptr;
+    writer.reset();
+    return true;
+}
+
+void EventExporter::abort() {
+    if (!isOpen()) {
+        return;
+    }
+
+    output.close();
+    records = nullptr;
+    writer.reset();
+
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
@@ -0,0 +1,936 @@
+#include "EventImporter.h"
+#include "EventSort.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+#include <omp.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define EVENT_IMPORTER_SSE2 1
+#endif
+
+using std::vector;
+
+// Input bytes decoded by one task
+static const size_t RANGE_BYTES = 4 << 20;
+
+static uint16_t load16(const char *p) {
+    uint16_t word;
+    std::memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+static uint32_t load32(const char *p) {
+    uint32_t word;
+    std::memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+/*
+    Writes the kept events of one range straight into their final slots of an EventColumns sized for the whole file,
+    so ranges decode in parallel without a stitching copy. A range rarely starts on a chunk or a polarity word though:
+    the base of its leading partial chunk is written by the previous range, so those times are kept relative to the
+    range's first event until finishRanges() rebases them, and bits of words shared with a neighbour are kept aside
+    and merged there.
+
+    Time order is checked on the way. If it is broken the ranges are decoded a second time into unpacked instead,
+    which is sorted as a whole (see decodeRanges).
+*/
+struct RangeWriter {
+    EventColumns *out = nullptr;
+    TimedEvent *unpacked = nullptr;
+    uint32_t modFreq = 1;
+    uint32_t skip = 0;  // raw events to drop before the next kept one
+    size_t first = 0;   // index of the range's first kept event
+    size_t end = 0;
+    size_t next = 0;
+    bool overrun = false; // more events than the first pass counted
+
+    int64_t base = 0;     // chunk base the next times are relative to
+    int64_t leadBase = 0; // stand-in base of the leading partial chunk
+    bool sharedFirst = false;
+    bool sharedLast = false;
+    uint64_t edgeWords[2] = {0, 0}; // polarity bits of the shared first / last word
+
+    uint16_t minX = UINT16_MAX;
+    uint16_t maxX = 0;
+    uint16_t minY = UINT16_MAX;
+    uint16_t maxY = 0;
+    int64_t minT = INT64_MAX;
+    int64_t maxT = INT64_MIN;
+    int64_t firstT = INT64_MIN;
+    int64_t lastT = INT64_MIN;
+    bool ordered = true;
+
+    void emit(uint16_t x, uint16_t y, int64_t t, bool p) {
+        if (skip > 0) {
+            skip--;
+            return;
+        }
+        skip = modFreq - 1;
+        write(x, y, t, p);
+    }
+
+    void write(uint16_t x, uint16_t y, int64_t t, bool p) {
+        if (next >= end) {
+            overrun = true;
+            return;
+        }
+
+        size_t i = next++;
+        if (i == first) {
+            firstT = t;
+        }
+        ordered = ordered && t >= lastT;
+        lastT = t;
+
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+
+        if (unpacked != nullptr) {
+            unpacked[i] = { t, x, y, p };
+            return;
+        }
+
+        if (i % EventColumns::CHUNK_EVENTS == 0) {
+            base = t;
+            out->chunkBase[i / EventColumns::CHUNK_EVENTS] = t;
+        }
+        else if (i == first) {
+            base = t;
+            leadBase = t;
+        }
+        out->x[i] = x;
+        out->y[i] = y;
+        out->dt[i] = static_cast<uint32_t>(std::clamp<int64_t>(t - base, 0, UINT32_MAX));
+
+        uint64_t bit = static_cast<uint64_t>(p) << (i & 63);
+        size_t word = i >> 6;
+        if (sharedFirst && word == first >> 6) {
+            edgeWords[0] |= bit;
+        }
+        else if (sharedLast && word == (end - 1) >> 6) {
+            edgeWords[1] |= bit;
+        }
+        else {
+            out->polarityBits[word] |= bit;
+        }
+    }
+};
+
+/*
+    Places every range's kept events given the raw event counts of the first pass; event i of the file is kept if
+    i % modFreq == 0. Sizes out for all of them.
+*/
+static size_t setupWriters(const vector<uint64_t> &rawCounts, uint32_t modFreq, EventColumns &out, vector<RangeWriter> &writers) {
+    auto keptBefore = [&](uint64_t raw) { return static_cast<size_t>((raw + modFreq - 1) / modFreq); };
+
+    writers.assign(rawCounts.size(), RangeWriter());
+    uint64_t raw = 0;
+    for (size_t r = 0; r < rawCounts.size(); r++) {
+        RangeWriter &writer = writers[r];
+        writer.out = &out;
+        writer.modFreq = modFreq;
+        writer.skip = static_cast<uint32_t>((modFreq - raw % modFreq) % modFreq);
+        writer.first = keptBefore(raw);
+        writer.end = keptBefore(raw + rawCounts[r]);
+        writer.next = writer.first;
+        raw += rawCounts[r];
+    }
+
+    size_t total = keptBefore(raw);
+    for (RangeWriter &writer : writers) {
+        writer.sharedFirst = writer.first % 64 != 0;
+        writer.sharedLast = writer.end % 64 != 0 && writer.end < total;
+    }
+
+    out.presize(total);
+    out.resize(total);
+    return total;
+}
+
+/*
+    Sequential fix-up after the parallel pass: rebases the leading partial chunk of every range and merges the shared
+    polarity words. At most one chunk per range is touched.
+*/
+static void finishRanges(EventColumns &out, const vector<RangeWriter> &writers) {
+    const size_t CHUNK = EventColumns::CHUNK_EVENTS;
+    for (const RangeWriter &writer : writers) {
+        if (writer.first == writer.end) {
+            continue;
+        }
+
+        if (writer.first % CHUNK != 0) {
+            int64_t delta = writer.leadBase - out.chunkBase[writer.first / CHUNK];
+            size_t stop = std::min(writer.end, (writer.first / CHUNK + 1) * CHUNK);
+            for (size_t i = writer.first; i < stop; i++) {
+                out.dt[i] = static_cast<uint32_t>(std::clamp<int64_t>(out.dt[i] + delta, 0, UINT32_MAX));
+            }
+        }
+
+        if (writer.sharedFirst) {
+            out.polarityBits[writer.first >> 6] |= writer.edgeWords[0];
+        }
+        if (writer.sharedLast) {
+            out.polarityBits[(writer.end - 1) >> 6] |= writer.edgeWords[1];
+        }
+    }
+}
+
+/*
+    Second pass shared by all formats: decode(r, writer) emits the raw events of range r in order.
+*/
+template <typename Decode>
+static bool decodeRanges(const std::string &path, const vector<uint64_t> &rawCounts, uint32_t modFreq,
+    const std::atomic<bool> &cancel, ImportedEvents &imported, Decode &&decode) {
+
+    vector<RangeWriter> writers;
+    const size_t total = setupWriters(rawCounts, modFreq, imported.events, writers);
+    if (total == 0) {
+        printf("No events in %s\n", path.c_str());
+        return false;
+    }
+
+    auto decodeAll = [&]() {
+        const int numRanges = static_cast<int>(writers.size());
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (int r = 0; r < numRanges; r++) {
+            if (!cancel) {
+                decode(r, writers[r]);
+            }
+        }
+        if (cancel) {
+            return false;
+        }
+
+        for (const RangeWriter &writer : writers) {
+            if (writer.overrun || writer.next != writer.end) {
+                printf("Could not import %s, its event count changed between passes\n", path.c_str());
+                return false;
+            }
+        }
+        return true;
+    };
+    if (!decodeAll()) {
+        return false;
+    }
+
+    // Ordered within every range and across range boundaries
+    bool ordered = true;
+    int64_t previousT = INT64_MIN;
+    for (const RangeWriter &writer : writers) {
+        if (writer.first < writer.end) {
+            ordered = ordered && writer.ordered && writer.firstT >= previousT;
+            previousT = writer.lastT;
+        }
+    }
+
+    if (ordered) {
+        finishRanges(imported.events, writers);
+    }
+    else {
+        printf("%s is not in time order, sorting %zu events\n", path.c_str(), total);
+
+        vector<TimedEvent> unpacked(total);
+        setupWriters(rawCounts, modFreq, imported.events, writers);
+        for (RangeWriter &writer : writers) {
+            writer.unpacked = unpacked.data();
+        }
+        if (!decodeAll()) {
+            return false;
+        }
+
+        EventSort::sortByTime(unpacked);
+        EventSort::toColumns(unpacked, imported.events);
+    }
+
+    uint16_t minX = UINT16_MAX, maxX = 0, minY = UINT16_MAX, maxY = 0;
+    int64_t minT = INT64_MAX, maxT = INT64_MIN;
+    for (const RangeWriter &writer : writers) {
+        minX = std::min(minX, writer.minX);
+        maxX = std::max(maxX, writer.maxX);
+        minY = std::min(minY, writer.minY);
+        maxY = std::max(maxY, writer.maxY);
+        minT = std::min(minT, writer.minT);
+        maxT = std::max(maxT, writer.maxT);
+    }
+    imported.earliestTimestamp = minT;
+    imported.latestTimestamp = std::max(maxT, minT + 1);
+    imported.minXY = glm::vec2(minX, minY);
+    imported.maxXY = glm::vec2(maxX, maxY);
+    return true;
+}
+
+// CSV //
+
+static const char *findNewline(const char *p, const char *end) {
+#ifdef EVENT_IMPORTER_SSE2
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; p + 16 <= end; p += 16) {
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), newline));
+        if (mask != 0) {
+            return p + std::countr_zero(static_cast<unsigned>(mask));
+        }
+    }
+#endif
+    for (; p < end; p++) {
+        if (*p == '\n') {
+            return p;
+        }
+    }
+    return end;
+}
+
+static uint64_t countNewlines(const char *p, const char *end) {
+    uint64_t count = 0;
+#ifdef EVENT_IMPORTER_SSE2
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; p + 16 <= end; p += 16) {
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), newline));
+        count += std::popcount(static_cast<unsigned>(mask));
+    }
+#endif
+    for (; p < end; p++) {
+        count += *p == '\n';
+    }
+    return count;
+}
+
+static bool isSeparator(char c) {
+    return c == ',' || c == ';' || c == ' ' || c == '\t' || c == '\r';
+}
+
+/**
+ * @brief Which field of a CSV line holds what.
+ */
+struct CsvLayout {
+    int t = 0;
+    int x = 1;
+    int y = 2;
+    int p = 3;
+    bool seconds = false; // timestamps have a decimal point
+};
+
+/*
+    Integer field, a fractional part is accepted and dropped (e.g. polarity written as 1.0).
+*/
+static bool parseInteger(const char *&p, const char *end, int64_t &value) {
+    bool negative = p < end && (*p == '-' || *p == '+') && *p++ == '-';
+    const char *digits = p;
+    value = 0;
+    while (p < end && static_cast<unsigned>(*p - '0') < 10) {
+        value = value * 10 + (*p++ - '0');
+    }
+    if (p == digits) {
+        return false;
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && static_cast<unsigned>(*p - '0') < 10; p++) {}
+    }
+    value = negative ? -value : value;
+    return p == end || isSeparator(*p);
+}
+
+/*
+    Timestamp field in microseconds; in seconds the fraction is read digit by digit, so no float rounding gets in.
+*/
+static bool parseTimestamp(const char *&p, const char *end, bool seconds, int64_t &timestamp) {
+    if (!seconds) {
+        return parseInteger(p, end, timestamp);
+    }
+
+    const char *digits = p;
+    int64_t whole = 0;
+    while (p < end && static_cast<unsigned>(*p - '0') < 10) {
+        whole = whole * 10 + (*p++ - '0');
+    }
+    int64_t micros = 0;
+    int scale = 100000;
+    if (p < end && *p == '.') {
+        for (p++; p < end && static_cast<unsigned>(*p - '0') < 10; p++) {
+            micros += (*p - '0') * scale;
+            scale /= 10;
+        }
+    }
+    timestamp = whole * 1000000 + micros;
+    return p != digits && (p == end || isSeparator(*p));
+}
+
+static bool parseCsvLine(const char *p, const char *end, const CsvLayout &layout, uint16_t &x, uint16_t &y, int64_t &t, bool &polarity) {
+    int found = 0;
+    for (int field = 0; found < 4; field++) {
+        while (p < end && isSeparator(*p)) {
+            p++;
+        }
+        if (p == end) {
+            return false;
+        }
+
+        int64_t value = 0;
+        if (field == layout.t) {
+            if (!parseTimestamp(p, end, layout.seconds, t)) {
+                return false;
+            }
+            found++;
+            continue;
+        }
+        if (field == layout.x || field == layout.y || field == layout.p) {
+            if (!parseInteger(p, end, value)) {
+                return false;
+            }
+            found++;
+        }
+        else {
+            while (p < end && !isSeparator(*p)) {
+                p++;
+            }
+        }
+
+        if (field == layout.x) {
+            x = static_cast<uint16_t>(value);
+        }
+        else if (field == layout.y) {
+            y = static_cast<uint16_t>(value);
+        }
+        else if (field == layout.p) {
+            polarity = value > 0;
+        }
+    }
+    return true;
+}
+
+static vector<std::string_view> splitFields(std::string_view line) {
+    vector<std::string_view> fields;
+    size_t i = 0;
+    while (i < line.size()) {
+        while (i < line.size() && isSeparator(line[i])) {
+            i++;
+        }
+        size_t start = i;
+        while (i < line.size() && !isSeparator(line[i])) {
+            i++;
+        }
+        if (i > start) {
+            fields.push_back(line.substr(start, i - start));
+        }
+    }
+    return fields;
+}
+
+/*
+    Column layout from a header line naming the columns; false if it does not name all four.
+*/
+static bool layoutFromHeader(std::string_view header, CsvLayout &layout) {
+    int t = -1, x = -1, y = -1, p = -1;
+    vector<std::string_view> names = splitFields(header);
+    for (int i = 0; i < static_cast<int>(names.size()); i++) {
+        std::string name(names[i]);
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+        name.erase(std::remove_if(name.begin(), name.end(), [](char c) { return c == '"' || c == '#' || c == '%'; }), name.end());
+        if (name == "t" || name == "ts" || name == "time" || name == "timestamp") t = i;
+        else if (name == "x") x = i;
+        else if (name == "y") y = i;
+        else if (name == "p" || name == "pol" || name == "polarity") p = i;
+    }
+    if (t < 0 || x < 0 || y < 0 || p < 0) {
+        return false;
+    }
+    layout.t = t;
+    layout.x = x;
+    layout.y = y;
+    layout.p = p;
+    return true;
+}
+
+/*
+    Without a header: the timestamp is the column written with a decimal point (seconds), else the one with the largest
+    value at the end of the file; x, y and polarity follow in the order of the remaining columns. Covers both t,x,y,p
+    and x,y,p,t dumps.
+*/
+static void layoutFromData(std::string_view lastLine, CsvLayout &layout) {
+    vector<std::string_view> fields = splitFields(lastLine);
+    if (fields.size() < 4) {
+        return;
+    }
+
+    int t = 0;
+    double largest = -1.0;
+    for (int i = 0; i < 4; i++) {
+        if (fields[i].find('.') != std::string_view::npos) {
+            t = i;
+            break;
+        }
+        double value = std::strtod(std::string(fields[i]).c_str(), nullptr);
+        if (value > largest) {
+            largest = value;
+            t = i;
+        }
+    }
+
+    int others[3], n = 0;
+    for (int i = 0; i < 4; i++) {
+        if (i != t) {
+            others[n++] = i;
+        }
+    }
+    layout.t = t;
+    layout.x = others[0];
+    layout.y = others[1];
+    layout.p = others[2];
+}
+
+static bool importCsv(const std::string &path, const char *data, size_t size, uint32_t modFreq,
+    const std::atomic<bool> &cancel, ImportedEvents &imported) {
+
+    const char *end = data + size;
+    while (end > data && (end[-1] == '\n' || end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t')) {
+        end--;
+    }
+
+    // Leading lines that do not start with a number are comments or the header
+    const char *begin = data;
+    std::string_view header;
+    while (begin < end) {
+        const char *first = begin;
+        while (first < end && (*first == ' ' || *first == '\t')) {
+            first++;
+        }
+        if (first < end && (static_cast<unsigned>(*first - '0') < 10 || *first == '-' || *first == '.')) {
+            break;
+        }
+        const char *lineEnd = findNewline(begin, end);
+        header = std::string_view(begin, lineEnd - begin);
+        begin = lineEnd < end ? lineEnd + 1 : end;
+    }
+    if (begin == end) {
+        printf("No events in %s\n", path.c_str());
+        return false;
+    }
+
+    CsvLayout layout;
+    if (header.empty() || !layoutFromHeader(header, layout)) {
+        const char *lastLine = end;
+        while (lastLine > begin && lastLine[-1] != '\n') {
+            lastLine--;
+        }
+        layoutFromData(std::string_view(lastLine, end - lastLine), layout);
+    }
+    {
+        // Seconds or microseconds, decided once from the first line
+        vector<std::string_view> fields = splitFields(std::string_view(begin, findNewline(begin, end) - begin));
+        layout.seconds = layout.t < static_cast<int>(fields.size()) && fields[layout.t].find('.') != std::string_view::npos;
+    }
+
+    // Ranges end on line ends
+    vector<const char *> bounds = { begin };
+    while (bounds.back() < end) {
+        const char *next = bounds.back() + std::min<size_t>(RANGE_BYTES, end - bounds.back());
+        next = next < end ? findNewline(next, end) : end;
+        bounds.push_back(next < end ? next + 1 : end);
+    }
+    const int numRanges = static_cast<int>(bounds.size()) - 1;
+
+    // First pass: one event per line, the last line has no newline since the end was trimmed
+    vector<uint64_t> lines(numRanges);
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int r = 0; r < numRanges; r++) {
+        lines[r] = countNewlines(bounds[r], bounds[r + 1]) + (bounds[r + 1] == end ? 1 : 0);
+    }
+    if (cancel) {
+        return false;
+    }
+
+    std::atomic<bool> malformed(false);
+    bool ok = decodeRanges(path, lines, modFreq, cancel, imported, [&](int r, RangeWriter &writer) {
+        const char *p = bounds[r];
+        const char *rangeEnd = bounds[r + 1];
+        while (p < rangeEnd) {
+            const char *lineEnd = findNewline(p, rangeEnd);
+            uint16_t x = 0, y = 0;
+            int64_t t = 0;
+            bool polarity = false;
+            if (!parseCsvLine(p, lineEnd, layout, x, y, t, polarity)) {
+                if (!malformed.exchange(true)) {
+                    printf("Could not import %s, malformed line: %.*s\n", path.c_str(), static_cast<int>(std::min<ptrdiff_t>(lineEnd - p, 80)), p);
+                }
+                return;
+            }
+            writer.emit(x, y, t, polarity);
+            p = lineEnd + 1;
+        }
+    });
+    return ok && !malformed;
+}
+
+// EVT 2.0 / 3.0 //
+
+/*
+    Skips the % header of a raw file; reads the format and sensor size from it.
+*/
+static size_t parseRawHeader(const char *data, size_t size, int &version, glm::vec2 &resolution) {
+    size_t pos = 0;
+    while (pos < size && data[pos] == '%') {
+        const char *lineEnd = static_cast<const char *>(std::memchr(data + pos, '\n', size - pos));
+        size_t next = lineEnd ? lineEnd - data + 1 : size;
+
+        std::string line(data + pos, next - pos);
+        std::transform(line.begin(), line.end(), line.begin(), [](unsigned char c) { return std::tolower(c); });
+        pos = next;
+
+        if (line.find("evt 3") != std::string::npos || line.find("evt3") != std::string::npos) {
+            version = 3;
+        }
+        else if (line.find("evt 2.1") != std::string::npos || line.find("evt21") != std::string::npos) {
+            version = 21;
+        }
+        else if (line.find("evt 2") != std::string::npos || line.find("evt2") != std::string::npos) {
+            version = 2;
+        }
+
+        int width = 0, height = 0;
+        size_t at;
+        if ((at = line.find("geometry")) != std::string::npos && std::sscanf(line.c_str() + at, "geometry %dx%d", &width, &height) == 2) {
+            resolution = glm::vec2(width, height);
+        }
+        if ((at = line.find("width=")) != std::string::npos && std::sscanf(line.c_str() + at, "width=%d", &width) == 1) {
+            resolution.x = static_cast<float>(width);
+        }
+        if ((at = line.find("height=")) != std::string::npos && std::sscanf(line.c_str() + at, "height=%d", &height) == 1) {
+            resolution.y = static_cast<float>(height);
+        }
+
+        if (line.rfind("% end", 0) == 0) {
+            break;
+        }
+    }
+    return pos;
+}
+
+/**
+ * @brief What the first pass learns from one range of EVT 2.0 words.
+ */
+struct Evt2Summary {
+    uint64_t events = 0;
+    int64_t firstHigh = -1;
+    int64_t lastHigh = -1;
+    int64_t wraps = 0; // time high going backwards inside the range
+};
+
+/**
+ * @brief Time high in effect at the start of a range, with the wraps of the 34-bit timestamp so far.
+ */
+struct Evt2State {
+    int64_t high = 0;
+    int64_t wraps = 0;
+};
+
+static void summarizeEvt2(const char *words, size_t n, Evt2Summary &summary) {
+    auto timeHigh = [&](uint32_t word) {
+        int64_t high = word & 0x0FFFFFFF;
+        if (summary.firstHigh < 0) {
+            summary.firstHigh = high;
+        }
+        else if (high < summary.lastHigh) {
+            summary.wraps++;
+        }
+        summary.lastHigh = high;
+    };
+
+    size_t i = 0;
+#ifdef EVENT_IMPORTER_SSE2
+    // CD events are types 0 and 1, i.e. the top 3 bits clear; time highs (type 8) are rare and taken one by one
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i typeHigh = _mm_set1_epi32(8);
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(words + i * 4));
+        int cd = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_srli_epi32(v, 29), zero)));
+        int high = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_srli_epi32(v, 28), typeHigh)));
+        summary.events += std::popcount(static_cast<unsigned>(cd));
+        while (high != 0) {
+            timeHigh(load32(words + (i + std::countr_zero(static_cast<unsigned>(high))) * 4));
+            high &= high - 1;
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        uint32_t word = load32(words + i * 4);
+        uint32_t type = word >> 28;
+        if (type <= 1) {
+            summary.events++;
+        }
+        else if (type == 8) {
+            timeHigh(word);
+        }
+    }
+}
+
+static void decodeEvt2(const char *words, size_t n, Evt2State state, RangeWriter &writer) {
+    int64_t high = state.high;
+    int64_t wrapBase = state.wraps << 34;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t word = load32(words + i * 4);
+        uint32_t type = word >> 28;
+        if (type <= 1) {
+            int64_t t = wrapBase + ((high << 6) | ((word >> 22) & 63));
+            writer.emit(static_cast<uint16_t>((word >> 11) & 2047), static_cast<uint16_t>(word & 2047), t, type == 1);
+        }
+        else if (type == 8) {
+            int64_t next = word & 0x0FFFFFFF;
+            if (next < high) {
+                wrapBase += int64_t(1) << 34;
+            }
+            high = next;
+        }
+    }
+}
+
+/**
+ * @brief What the first pass learns from one range of EVT 3.0 words; -1 where the range does not set the value.
+ */
+struct Evt3Summary {
+    uint64_t events = 0;
+    int y = -1;
+    int baseX = -1;
+    bool basePolarity = false;
+    int64_t advance = 0; // x advance of the vectors after the last base, or of all of them without one
+    int firstHigh = -1;
+    int lastHigh = -1;
+    int64_t wraps = 0;
+    int low = -1;        // last time low after the last time high, or in the whole range without one
+};
+
+/**
+ * @brief EVT 3.0 decoder state at the start of a range.
+ */
+struct Evt3State {
+    int y = 0;
+    int64_t baseX = 0;
+    bool polarity = false;
+    int64_t high = 0;
+    int64_t low = 0;
+    int64_t wraps = 0; // of the 24-bit timestamp
+
+    int64_t time() const { return (wraps << 24) + (high << 12) + low; }
+};
+
+static void summarizeEvt3(const char *words, size_t n, Evt3Summary &summary) {
+    for (size_t i = 0; i < n; i++) {
+        uint16_t word = load16(words + i * 2);
+        switch (word >> 12) {
+            case 0x0: summary.y = word & 0x7FF; break;
+            case 0x2: summary.events++; break;
+            case 0x3:
+                summary.baseX = word & 0x7FF;
+                summary.basePolarity = (word >> 11) & 1;
+                summary.advance = 0;
+                break;
+            case 0x4:
+                summary.events += std::popcount(static_cast<unsigned>(word & 0xFFF));
+                summary.advance += 12;
+                break;
+            case 0x5:
+                summary.events += std::popcount(static_cast<unsigned>(word & 0xFF));
+                summary.advance += 8;
+                break;
+            case 0x6: summary.low = word & 0xFFF; break;
+            case 0x8: {
+                int high = word & 0xFFF;
+                if (summary.firstHigh < 0) {
+                    summary.firstHigh = high;
+                }
+                else if (high < summary.lastHigh) {
+                    summary.wraps++;
+                }
+                summary.lastHigh = high;
+                summary.low = -1;
+                break;
+            }
+            default: break; // continued, triggers and others carry no CD events
+        }
+    }
+}
+
+static void decodeEvt3(const char *words, size_t n, Evt3State state, RangeWriter &writer) {
+    int64_t t = state.time();
+    for (size_t i = 0; i < n; i++) {
+        uint16_t word = load16(words + i * 2);
+        switch (word >> 12) {
+            case 0x0: state.y = word & 0x7FF; break;
+            case 0x2:
+                writer.emit(static_cast<uint16_t>(word & 0x7FF), static_cast<uint16_t>(state.y), t, (word >> 11) & 1);
+                break;
+            case 0x3:
+                state.baseX = word & 0x7FF;
+                state.polarity = (word >> 11) & 1;
+                break;
+            case 0x4:
+            case 0x5: {
+                // One bit per pixel from baseX on, 12 or 8 of them
+                bool wide = (word >> 12) == 0x4;
+                unsigned valid = word & (wide ? 0xFFF : 0xFF);
+                while (valid != 0) {
+                    writer.emit(static_cast<uint16_t>(state.baseX + std::countr_zero(valid)), static_cast<uint16_t>(state.y), t, state.polarity);
+                    valid &= valid - 1;
+                }
+                state.baseX += wide ? 12 : 8;
+                break;
+            }
+            case 0x6:
+                state.low = word & 0xFFF;
+                t = state.time();
+                break;
+            case 0x8: {
+                int64_t high = word & 0xFFF;
+                if (high < state.high) {
+                    state.wraps++;
+                }
+                state.high = high;
+                state.low = 0;
+                t = state.time();
+                break;
+            }
+            default: break;
+        }
+    }
+}
+
+static bool importRaw(const std::string &path, const char *data, size_t size, uint32_t modFreq,
+    const std::atomic<bool> &cancel, ImportedEvents &imported) {
+
+    int version = 0;
+    size_t headerBytes = parseRawHeader(data, size, version, imported.resolution);
+    if (version != 2 && version != 3) {
+        printf("Could not import %s, only EVT 2.0 and EVT 3.0 raw files are supported\n", path.c_str());
+        return false;
+    }
+
+    const char *words = data + headerBytes;
+    const size_t wordBytes = version == 2 ? 4 : 2;
+    const size_t numWords = (size - headerBytes) / wordBytes;
+    const size_t rangeWords = RANGE_BYTES / wordBytes;
+    const int numRanges = static_cast<int>((numWords + rangeWords - 1) / rangeWords);
+    auto rangeStart = [&](int r) { return std::min(static_cast<size_t>(r) * rangeWords, numWords); };
+    auto rangeSize = [&](int r) { return rangeStart(r + 1) - rangeStart(r); };
+
+    /*
+        First pass: events per range and the decoder state each range leaves behind. States are then chained in
+        order, so every range of the second pass starts with exactly the state a sequential decode would have there.
+    */
+    vector<uint64_t> counts(numRanges);
+    if (version == 2) {
+        vector<Evt2Summary> summaries(numRanges);
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (int r = 0; r < numRanges; r++) {
+            summarizeEvt2(words + rangeStart(r) * wordBytes, rangeSize(r), summaries[r]);
+        }
+
+        vector<Evt2State> states(numRanges);
+        Evt2State state;
+        for (int r = 0; r < numRanges; r++) {
+            states[r] = state;
+            counts[r] = summaries[r].events;
+            if (summaries[r].firstHigh >= 0) {
+                state.wraps += (summaries[r].firstHigh < state.high ? 1 : 0) + summaries[r].wraps;
+                state.high = summaries[r].lastHigh;
+            }
+        }
+        if (cancel) {
+            return false;
+        }
+
+        return decodeRanges(path, counts, modFreq, cancel, imported, [&](int r, RangeWriter &writer) {
+            decodeEvt2(words + rangeStart(r) * wordBytes, rangeSize(r), states[r], writer);
+        });
+    }
+
+    vector<Evt3Summary> summaries(numRanges);
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int r = 0; r < numRanges; r++) {
+        summarizeEvt3(words + rangeStart(r) * wordBytes, rangeSize(r), summaries[r]);
+    }
+
+    vector<Evt3State> states(numRanges);
+    Evt3State state;
+    for (int r = 0; r < numRanges; r++) {
+        const Evt3Summary &summary = summaries[r];
+        states[r] = state;
+        counts[r] = summary.events;
+
+        if (summary.y >= 0) {
+            state.y = summary.y;
+        }
+        if (summary.baseX >= 0) {
+            state.baseX = summary.baseX + summary.advance;
+            state.polarity = summary.basePolarity;
+        }
+        else {
+            state.baseX += summary.advance;
+        }
+        if (summary.firstHigh >= 0) {
+            state.wraps += (summary.firstHigh < state.high ? 1 : 0) + summary.wraps;
+            state.high = summary.lastHigh;
+            state.low = summary.low >= 0 ? summary.low : 0;
+        }
+        else if (summary.low >= 0) {
+            state.low = summary.low;
+        }
+    }
+    if (cancel) {
+        return false;
+    }
+
+    return decodeRanges(path, counts, modFreq, cancel, imported, [&](int r, RangeWriter &writer) {
+        decodeEvt3(words + rangeStart(r) * wordBytes, rangeSize(r), states[r], writer);
+    });
+}
+
+static std::string lowerExtension(const std::string &path) {
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+    return extension;
+}
+
+bool EventImporter::canImport(const std::string &path) {
+    std::string extension = lowerExtension(path);
+    return extension == ".raw" || extension == ".csv" || extension == ".txt";
+}
+
+bool EventImporter::import(const std::string &path, uint32_t modFreq, const std::atomic<bool> &cancel, ImportedEvents &out) {
+    MappedFile file;
+    if (!file.open(path)) {
+        printf("Could not open %s\n", path.c_str());
+        return false;
+    }
+    const char *data = reinterpret_cast<const char *>(file.data());
+    modFreq = std::max(modFreq, 1u);
+
+    out.resolution = glm::vec2(0.0f);
+    bool ok = lowerExtension(path) == ".raw"
+        ? importRaw(path, data, file.size(), modFreq, cancel, out)
+        : importCsv(path, data, file.size(), modFreq, cancel, out);
+    if (!ok) {
+        out.events.release();
+        return false;
+    }
+
+    // Text dumps carry no sensor size
+    if (out.resolution.x <= 0.0f || out.resolution.y <= 0.0f) {
+        out.resolution = glm::vec2(out.maxXY.x + 1.0f, out.maxXY.y + 1.0f);
+    }
+
+    printf("Imported %zu events from %s\n", out.events.size(), path.c_str());
+    return true;
+}
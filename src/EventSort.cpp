@@ -0,0 +1,113 @@
+#include "EventSort.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <omp.h>
+
+void EventSort::sortByTime(std::vector<TimedEvent> &events) {
+    if (events.size() < 2) {
+        return;
+    }
+
+    // Per thread slices throughout; no min / max reductions in OpenMP 2.0
+    const int maxThreads = omp_get_max_threads();
+    std::vector<int64_t> threadLowest(maxThreads, INT64_MAX);
+    std::vector<int64_t> threadHighest(maxThreads, INT64_MIN);
+    #pragma omp parallel
+    {
+        const int thread = omp_get_thread_num();
+        const int numThreads = omp_get_num_threads();
+        const size_t end = events.size() * (thread + 1) / numThreads;
+        int64_t lo = INT64_MAX, hi = INT64_MIN;
+        for (size_t i = events.size() * thread / numThreads; i < end; i++) {
+            lo = std::min(lo, events[i].timestamp);
+            hi = std::max(hi, events[i].timestamp);
+        }
+        threadLowest[thread] = lo;
+        threadHighest[thread] = hi;
+    }
+    const int64_t lowest = *std::min_element(threadLowest.begin(), threadLowest.end());
+    const int64_t highest = *std::max_element(threadHighest.begin(), threadHighest.end());
+
+    // Keys are relative to the earliest event, so the passes only cover the bits the span uses
+    const uint64_t span = static_cast<uint64_t>(highest - lowest);
+    const int passes = (std::bit_width(span) + 7) / 8;
+
+    std::vector<TimedEvent> scratch(events.size());
+    TimedEvent *src = events.data();
+    TimedEvent *dst = scratch.data();
+
+    /*
+        Every thread counts the digits of its own contiguous slice, the counts are turned into the slice's scatter
+        offsets for every digit (digit major, thread minor), and every thread scatters its slice. Threads write
+        disjoint slots and keep the order of their slice, so the pass is stable.
+    */
+    std::vector<std::array<size_t, 256>> offsets(maxThreads);
+    for (int pass = 0; pass < passes; pass++) {
+        const int shift = pass * 8;
+        auto digit = [&](const TimedEvent &event) {
+            return static_cast<size_t>((static_cast<uint64_t>(event.timestamp - lowest) >> shift) & 0xFF);
+        };
+
+        #pragma omp parallel
+        {
+            const int thread = omp_get_thread_num();
+            const int numThreads = omp_get_num_threads();
+            const size_t begin = events.size() * thread / numThreads;
+            const size_t end = events.size() * (thread + 1) / numThreads;
+
+            std::array<size_t, 256> &counts = offsets[thread];
+            counts.fill(0);
+            for (size_t i = begin; i < end; i++) {
+                counts[digit(src[i])]++;
+            }
+
+            #pragma omp barrier
+            #pragma omp single
+            {
+                size_t offset = 0;
+                for (size_t d = 0; d < 256; d++) {
+                    for (int t = 0; t < numThreads; t++) {
+                        size_t count = offsets[t][d];
+                        offsets[t][d] = offset;
+                        offset += count;
+                    }
+                }
+            }
+
+            for (size_t i = begin; i < end; i++) {
+                dst[counts[digit(src[i])]++] = src[i];
+            }
+        }
+        std::swap(src, dst);
+    }
+
+    if (src != events.data()) {
+        events.swap(scratch);
+    }
+}
+
+void EventSort::toColumns(std::span<const TimedEvent> events, EventColumns &out) {
+    out.presize(events.size());
+    out.resize(events.size());
+
+    // Chunks hold a whole number of polarity words, so no two tasks write the same one
+    const size_t CHUNK = EventColumns::CHUNK_EVENTS;
+    const int numChunks = static_cast<int>(EventColumns::chunksFor(events.size()));
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (int c = 0; c < numChunks; c++) {
+        const size_t first = static_cast<size_t>(c) * CHUNK;
+        const size_t last = std::min(first + CHUNK, events.size());
+        const int64_t base = events[first].timestamp;
+        out.chunkBase[c] = base;
+
+        for (size_t i = first; i < last; i++) {
+            const TimedEvent &event = events[i];
+            out.x[i] = event.x;
+            out.y[i] = event.y;
+            out.dt[i] = static_cast<uint32_t>(std::min<int64_t>(event.timestamp - base, UINT32_MAX));
+            out.polarityBits[i >> 6] |= static_cast<uint64_t>(event.polarity != 0) << (i & 63);
+        }
+    }
+}
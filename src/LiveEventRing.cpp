@@ -0,0 +1,75 @@
+#include "LiveEventRing.h"
+
+#include <algorithm>
+#include <bit>
+
+void LiveEventRing::reset(size_t capacity) {
+    capacity = capacity > 0 ? std::bit_ceil(capacity) : 0;
+    x.assign(capacity, 0);
+    y.assign(capacity, 0);
+    timestamps.assign(capacity, 0);
+    polarity.assign(capacity, 0);
+    mask = capacity > 0 ? capacity - 1 : 0;
+
+    pushed = 0;
+    newest = INT64_MIN;
+    published.store(0, std::memory_order_relaxed);
+    claimed.store(0, std::memory_order_relaxed);
+
+    std::vector<uint16_t>().swap(stagingX);
+    std::vector<uint16_t>().swap(stagingY);
+    std::vector<int64_t>().swap(stagingTimestamps);
+    std::vector<uint8_t>().swap(stagingPolarity);
+}
+
+void LiveEventRing::push(uint16_t evtX, uint16_t evtY, int64_t timestamp, bool evtPolarity) {
+    if (timestamp < newest || timestamps.empty()) {
+        return;
+    }
+    newest = timestamp;
+
+    // Announce the eviction before touching the slot, read() checks claimed after its copy
+    claimed.store(pushed + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    size_t slot = pushed & mask;
+    x[slot] = evtX;
+    y[slot] = evtY;
+    timestamps[slot] = timestamp;
+    polarity[slot] = evtPolarity;
+    pushed++;
+}
+
+uint64_t LiveEventRing::read(uint64_t from, EventColumns &out) const {
+    const uint64_t cap = capacity();
+    const uint64_t head = published.load(std::memory_order_acquire);
+    const uint64_t first = std::max(from, head > cap ? head - cap : 0);
+    if (first >= head) {
+        return head;
+    }
+
+    // Raw copies first, timestamps of overwritten slots may be torn and must not become chunk bases
+    const size_t n = static_cast<size_t>(head - first);
+    stagingX.resize(n);
+    stagingY.resize(n);
+    stagingTimestamps.resize(n);
+    stagingPolarity.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        size_t slot = (first + i) & mask;
+        stagingX[i] = x[slot];
+        stagingY[i] = y[slot];
+        stagingTimestamps[i] = timestamps[slot];
+        stagingPolarity[i] = polarity[slot];
+    }
+
+    // Everything the producer started overwriting during the copy is suspect
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t evicting = claimed.load(std::memory_order_relaxed);
+    const size_t skipped = static_cast<size_t>(std::max(first, evicting > cap ? evicting - cap : 0) - first); // overwritten
+
+    for (size_t i = skipped; i < n; i++) {
+        out.push_back(stagingX[i], stagingY[i], stagingTimestamps[i], stagingPolarity[i] != 0);
+    }
+
+    return head;
+}
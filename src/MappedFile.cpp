@@ -0,0 +1,198 @@
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <utility>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        close();
+        ptr = std::exchange(other.ptr, nullptr);
+        length = std::exchange(other.length, 0);
+        writable = std::exchange(other.writable, false);
+        fileHandle = std::exchange(other.fileHandle, nullptr);
+        mappingHandle = std::exchange(other.mappingHandle, nullptr);
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string &path) {
+    close();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    ptr = view;
+    length = static_cast<size_t>(fileSize.QuadPart);
+    fileHandle = file;
+    mappingHandle = mapping;
+    return true;
+}
+
+bool MappedFile::create(const std::string &path, size_t size) {
+    close();
+    if (size == 0) {
+        return false;
+    }
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    // The mapping sets the file size, no SetEndOfFile needed
+    const uint64_t size64 = size;
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, static_cast<DWORD>(size64 >> 32),
+        static_cast<DWORD>(size64 & 0xFFFFFFFF), nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void *view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    ptr = view;
+    length = size;
+    writable = true;
+    fileHandle = file;
+    mappingHandle = mapping;
+    return true;
+}
+
+void MappedFile::close() {
+    if (ptr) {
+        UnmapViewOfFile(ptr);
+    }
+    if (mappingHandle) {
+        CloseHandle(static_cast<HANDLE>(mappingHandle));
+    }
+    if (fileHandle) {
+        CloseHandle(static_cast<HANDLE>(fileHandle));
+    }
+
+    ptr = nullptr;
+    length = 0;
+    writable = false;
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::string &path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void *view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+
+    ptr = view;
+    length = static_cast<size_t>(st.st_size);
+    fileHandle = reinterpret_cast<void *>(static_cast<intptr_t>(fd) + 1); // +1 so fd 0 is not mistaken for "closed"
+    return true;
+}
+
+bool MappedFile::create(const std::string &path, size_t size) {
+    close();
+    if (size == 0) {
+        return false;
+    }
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void *view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+
+    ptr = view;
+    length = size;
+    writable = true;
+    fileHandle = reinterpret_cast<void *>(static_cast<intptr_t>(fd) + 1);
+    return true;
+}
+
+void MappedFile::close() {
+    if (ptr) {
+        munmap(ptr, length);
+    }
+    if (fileHandle) {
+        ::close(static_cast<int>(reinterpret_cast<intptr_t>(fileHandle) - 1));
+    }
+
+    ptr = nullptr;
+    length = 0;
+    writable = false;
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+}
+
+#endif
@@ -0,0 +1,221 @@
+#include "PagedEventStore.h"
+
+#include <algorithm>
+
+PagedEventStore::~PagedEventStore() {
+    close();
+}
+
+bool PagedEventStore::open(const std::string &path, uint64_t dataOffset, uint64_t eventCount, size_t maxResidentBlocks) {
+    close();
+
+    file.open(path, std::ios::binary);
+    if (!file || eventCount == 0) {
+        file.close();
+        return false;
+    }
+
+    this->layout = EventColumnsLayout::of(eventCount, dataOffset);
+    this->maxResidentBlocks = std::max(maxResidentBlocks, READAHEAD_BLOCKS + 1);
+
+    /*
+        Time bounds of every block. A block starts a chunk, so its first timestamp is that chunk's base; the last one is
+        the base of the last chunk plus the last offset.
+    */
+    const size_t CHUNK = EventColumns::CHUNK_EVENTS;
+    size_t blockCount = (eventCount + BLOCK_EVENTS - 1) / BLOCK_EVENTS;
+    blockFirstT.resize(blockCount);
+    blockLastT.resize(blockCount);
+    for (size_t b = 0; b < blockCount; b++) {
+        size_t first = blockStart(b);
+        size_t last = std::min(first + BLOCK_EVENTS, static_cast<size_t>(eventCount)) - 1;
+        uint32_t lastDt;
+
+        if (!readAt(layout.chunkBase + first / CHUNK * sizeof(int64_t), &blockFirstT[b], sizeof(int64_t))
+            || !readAt(layout.chunkBase + last / CHUNK * sizeof(int64_t), &blockLastT[b], sizeof(int64_t))
+            || !readAt(layout.dt + last * sizeof(uint32_t), &lastDt, sizeof(uint32_t))) {
+            close();
+            return false;
+        }
+        blockLastT[b] += lastDt;
+    }
+
+    this->eventCount = static_cast<size_t>(eventCount);
+    stopReadahead = false;
+    readaheadThread = std::thread(&PagedEventStore::readaheadWorker, this);
+
+    return true;
+}
+
+void PagedEventStore::close() {
+    if (readaheadThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(readaheadMutex);
+            stopReadahead = true;
+            readaheadQueue.clear();
+        }
+        readaheadCv.notify_all();
+        readaheadThread.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(residentMutex);
+        resident.clear();
+        lru.clear();
+    }
+
+    file.close();
+    file.clear();
+    eventCount = 0;
+    blockFirstT.clear();
+    blockLastT.clear();
+    windowFirst = 0;
+    movingBackwards = false;
+}
+
+bool PagedEventStore::readAt(uint64_t offset, void *dst, size_t bytes) const {
+    file.seekg(static_cast<std::streamoff>(offset));
+    file.read(static_cast<char *>(dst), static_cast<std::streamsize>(bytes));
+    if (!file) {
+        file.clear();
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<EventColumns> PagedEventStore::readBlock(size_t b) const {
+    size_t first = blockStart(b);
+    size_t count = std::min(first + BLOCK_EVENTS, eventCount) - first;
+    auto block = std::make_shared<EventColumns>();
+    block->resize(count);
+
+    // One read per column; first is a multiple of CHUNK_EVENTS, so the block's polarity and chunk bases start whole
+    std::lock_guard<std::mutex> lock(fileMutex);
+    bool ok = readAt(layout.x + first * sizeof(uint16_t), block->x.data(), count * sizeof(uint16_t))
+        && readAt(layout.y + first * sizeof(uint16_t), block->y.data(), count * sizeof(uint16_t))
+        && readAt(layout.dt + first * sizeof(uint32_t), block->dt.data(), count * sizeof(uint32_t))
+        && readAt(layout.polarity + first / 64 * sizeof(uint64_t), block->polarityBits.data(),
+            block->polarityBits.size() * sizeof(uint64_t))
+        && readAt(layout.chunkBase + first / EventColumns::CHUNK_EVENTS * sizeof(int64_t), block->chunkBase.data(),
+            block->chunkBase.size() * sizeof(int64_t));
+    if (!ok) {
+        // Truncated or unreadable file; hand out zeroed events rather than garbage
+        block->clear();
+        block->resize(count);
+    }
+
+    return block;
+}
+
+PagedEventStore::Block PagedEventStore::insertBlock(size_t b, Block block) const {
+    std::lock_guard<std::mutex> lock(residentMutex);
+
+    // Another thread may have read the same block meanwhile, keep the first copy
+    auto it = resident.find(b);
+    if (it != resident.end()) {
+        return it->second.first;
+    }
+
+    lru.push_front(b);
+    resident.emplace(b, std::make_pair(block, lru.begin()));
+
+    while (resident.size() > maxResidentBlocks) {
+        resident.erase(lru.back());
+        lru.pop_back();
+    }
+
+    return block;
+}
+
+PagedEventStore::Block PagedEventStore::getBlock(size_t b) const {
+    {
+        std::lock_guard<std::mutex> lock(residentMutex);
+        auto it = resident.find(b);
+        if (it != resident.end()) {
+            lru.splice(lru.begin(), lru, it->second.second);
+            return it->second.first;
+        }
+    }
+
+    return insertBlock(b, readBlock(b));
+}
+
+int64_t PagedEventStore::getTimestamp(size_t i) const {
+    return getBlock(blockOf(i))->view().getTimestamp(i - blockStart(blockOf(i)));
+}
+
+size_t PagedEventStore::lowerBound(int64_t timestamp) const {
+    // First block whose last event could be the answer
+    size_t b = std::lower_bound(blockLastT.begin(), blockLastT.end(), timestamp) - blockLastT.begin();
+    if (b == blockLastT.size()) {
+        return eventCount;
+    }
+
+    return blockStart(b) + getBlock(b)->view().lowerBound(timestamp);
+}
+
+size_t PagedEventStore::upperBound(int64_t timestamp) const {
+    size_t b = std::upper_bound(blockLastT.begin(), blockLastT.end(), timestamp) - blockLastT.begin();
+    if (b == blockLastT.size()) {
+        return eventCount;
+    }
+
+    return blockStart(b) + getBlock(b)->view().upperBound(timestamp);
+}
+
+void PagedEventStore::setWindow(size_t first, size_t last) {
+    if (!isOpen() || first > last) {
+        return;
+    }
+
+    if (first != windowFirst) {
+        movingBackwards = first < windowFirst;
+        windowFirst = first;
+    }
+
+    std::vector<size_t> wanted;
+    for (size_t n = 1; n <= READAHEAD_BLOCKS; n++) {
+        if (movingBackwards) {
+            if (blockOf(first) < n) {
+                break;
+            }
+            wanted.push_back(blockOf(first) - n);
+        }
+        else {
+            if (blockOf(last) + n >= getBlockCount()) {
+                break;
+            }
+            wanted.push_back(blockOf(last) + n);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(readaheadMutex);
+        readaheadQueue.assign(wanted.begin(), wanted.end());
+    }
+    readaheadCv.notify_one();
+}
+
+void PagedEventStore::readaheadWorker() {
+    while (true) {
+        size_t b;
+        {
+            std::unique_lock<std::mutex> lock(readaheadMutex);
+            readaheadCv.wait(lock, [this] { return stopReadahead || !readaheadQueue.empty(); });
+            if (stopReadahead) {
+                return;
+            }
+            b = readaheadQueue.front();
+            readaheadQueue.pop_front();
+        }
+
+        bool isResident;
+        {
+            std::lock_guard<std::mutex> lock(residentMutex);
+            isResident = resident.count(b) > 0;
+        }
+        if (!isResident) {
+            insertBlock(b, readBlock(b));
+        }
+    }
+}
@@ -0,0 +1,125 @@
+#include "PixelPrefix.h"
+
+#include <algorithm>
+#include <omp.h>
+
+static const size_t PIXEL_BLOCK = 4096; // pixels per task of the running sums, keeps their rows contiguous
+
+void PixelPrefix::build(const EventColumnsView &events, glm::vec2 cameraResolution, size_t budgetBytes) {
+    clear();
+
+    const int w = static_cast<int>(cameraResolution.x);
+    const int h = static_cast<int>(cameraResolution.y);
+    if (events.empty() || w <= 0 || h <= 0) {
+        return;
+    }
+    const size_t pixels = static_cast<size_t>(w) * h;
+
+    // Checkpoint 0 is all zeros, so at least two have to fit
+    const size_t maxCheckpoints = budgetBytes / (pixels * 2 * sizeof(uint32_t));
+    const size_t wanted = maxCheckpoints < 2 ? 0 : std::min(maxCheckpoints - 1, events.size() / MIN_STRIDE);
+    if (wanted == 0) {
+        return;
+    }
+
+    width = w;
+    height = h;
+    eventCount = events.size();
+    stride = (events.size() + wanted - 1) / wanted;
+    checkpoints = events.size() / stride;
+    positiveCounts.assign((checkpoints + 1) * pixels, 0);
+    negativeCounts.assign((checkpoints + 1) * pixels, 0);
+
+    // Counts of every stride on its own, stored in the checkpoint that closes it
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int k = 0; k < static_cast<int>(checkpoints); k++) {
+        uint32_t *positive = positiveCounts.data() + (k + 1) * pixels;
+        uint32_t *negative = negativeCounts.data() + (k + 1) * pixels;
+        const size_t end = (k + 1) * stride;
+        for (size_t i = k * stride; i < end; i++) {
+            if (events.x[i] < width && events.y[i] < height) {
+                size_t pixel = static_cast<size_t>(events.y[i]) * width + events.x[i];
+                (events.getPolarity(i) != 0.0f ? positive : negative)[pixel]++;
+            }
+        }
+    }
+
+    // Then running sums over the checkpoints
+    const int blocks = static_cast<int>((pixels + PIXEL_BLOCK - 1) / PIXEL_BLOCK);
+    #pragma omp parallel for
+    for (int b = 0; b < blocks; b++) {
+        const size_t begin = b * PIXEL_BLOCK;
+        const size_t end = std::min(begin + PIXEL_BLOCK, pixels);
+        for (size_t k = 1; k <= checkpoints; k++) {
+            for (size_t p = begin; p < end; p++) {
+                positiveCounts[k * pixels + p] += positiveCounts[(k - 1) * pixels + p];
+                negativeCounts[k * pixels + p] += negativeCounts[(k - 1) * pixels + p];
+            }
+        }
+    }
+}
+
+void PixelPrefix::clear() {
+    width = 0;
+    height = 0;
+    eventCount = 0;
+    stride = 0;
+    checkpoints = 0;
+    ArenaVector<uint32_t>().swap(positiveCounts);
+    ArenaVector<uint32_t>().swap(negativeCounts);
+}
+
+void PixelPrefix::count(const EventColumnsView &events, size_t first, size_t last, ArenaVector<uint32_t> &positive,
+    ArenaVector<uint32_t> &negative) const {
+    const size_t pixels = static_cast<size_t>(width) * height;
+    positive.resize(pixels);
+    negative.resize(pixels);
+
+    // Checkpoints within [first, last + 1], their difference covers everything between them
+    const size_t checkpoint_L = (first + stride - 1) / stride;
+    const size_t checkpoint_R = std::min((last + 1) / stride, checkpoints);
+    size_t scanEnd = last + 1;
+    if (checkpoint_L <= checkpoint_R) {
+        const uint32_t *positive_L = positiveCounts.data() + checkpoint_L * pixels;
+        const uint32_t *positive_R = positiveCounts.data() + checkpoint_R * pixels;
+        const uint32_t *negative_L = negativeCounts.data() + checkpoint_L * pixels;
+        const uint32_t *negative_R = negativeCounts.data() + checkpoint_R * pixels;
+        #pragma omp parallel for
+        for (int p = 0; p < static_cast<int>(pixels); p++) {
+            positive[p] = positive_R[p] - positive_L[p];
+            negative[p] = negative_R[p] - negative_L[p];
+        }
+        scanEnd = checkpoint_L * stride;
+    }
+    else {
+        std::fill(positive.begin(), positive.end(), 0u);
+        std::fill(negative.begin(), negative.end(), 0u);
+    }
+
+    // The residual events before the first and after the last checkpoint
+    scanEnd = std::min(scanEnd, last + 1);
+    if (first < scanEnd) {
+        addEvents(events.subview(first, scanEnd - first), width, height, false, positive.data(), negative.data());
+    }
+    if (checkpoint_L <= checkpoint_R && checkpoint_R * stride <= last) {
+        addEvents(events.subview(checkpoint_R * stride, last + 1 - checkpoint_R * stride), width, height, false,
+            positive.data(), negative.data());
+    }
+}
+
+void PixelPrefix::addEvents(const EventColumnsView &events, int width, int height, bool subtract, uint32_t *positive,
+    uint32_t *negative) {
+    // Wraps around to subtract, the counts themselves never go below zero
+    const uint32_t step = subtract ? UINT32_MAX : 1u;
+
+    // Few events of a span hit the same pixel at once, atomics are fine
+    #pragma omp parallel for
+    for (int i = 0; i < static_cast<int>(events.size()); i++) {
+        if (events.x[i] < width && events.y[i] < height) {
+            size_t pixel = static_cast<size_t>(events.y[i]) * width + events.x[i];
+            uint32_t *counts = events.getPolarity(i) != 0.0f ? positive : negative;
+            #pragma omp atomic
+            counts[pixel] += step;
+        }
+    }
+}
@@ -0,0 +1,112 @@
+#include "Session.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+bool Session::isPlaylist(const std::string &path) {
+    return fs::path(path).extension() == ".m3u";
+}
+
+std::vector<std::string> Session::readPlaylist(const std::string &path) {
+    std::vector<std::string> recordings;
+    std::ifstream in(path);
+    if (!in) {
+        return recordings;
+    }
+
+    const fs::path directory = fs::path(path).parent_path();
+    std::string line;
+    while (std::getline(in, line)) {
+        // Tolerate CRLF and indentation
+        size_t first = line.find_first_not_of(" \t\r");
+        size_t last = line.find_last_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+
+        fs::path recording(line.substr(first, last - first + 1));
+        if (recording.is_relative()) {
+            recording = directory / recording;
+        }
+        recordings.push_back(recording.string());
+    }
+    return recordings;
+}
+
+bool Session::open(const std::string &path) {
+    close();
+
+    if (isPlaylist(path)) {
+        recordings = readPlaylist(path);
+        printf("Session of %zu recordings from %s\n", recordings.size(), path.c_str());
+    }
+    else {
+        recordings.push_back(path);
+    }
+
+    if (recordings.empty()) {
+        shown = std::make_shared<EventData>();
+        shown->initParticlesEmpty();
+        shown->initInstancing();
+        return false;
+    }
+
+    show(0);
+    return true;
+}
+
+void Session::close() {
+    // Cancels the loaders of both recordings
+    prefetched.reset();
+    shown.reset();
+    recordings.clear();
+    shownIndex = 0;
+    prefetchedIndex = 0;
+    requested = SIZE_MAX;
+}
+
+void Session::show(size_t index) {
+    if (prefetched && prefetchedIndex == index) {
+        shown = std::move(prefetched);
+    }
+    else {
+        shown = std::make_shared<EventData>();
+        shown->startStreamingFromFile(recordings[index]);
+        shown->initInstancing();
+    }
+    prefetched.reset(); // a prefetch of any other recording is of no use anymore
+    shownIndex = index;
+}
+
+bool Session::update() {
+    bool changed = false;
+    if (requested < recordings.size() && requested != shownIndex) {
+        show(requested);
+        changed = true;
+    }
+    requested = SIZE_MAX;
+
+    // Only start once the shown recording is complete, so the two loads never compete for the decode threads
+    if (!prefetched && hasNext() && shown->isLoadComplete()) {
+        prefetchedIndex = shownIndex + 1;
+        prefetched = std::make_shared<EventData>();
+        prefetched->startStreamingFromFile(recordings[prefetchedIndex]);
+        prefetched->initInstancing();
+    }
+
+    // Same per frame work as for the shown recording, so nothing is left to do when it is switched to
+    if (prefetched) {
+        prefetched->streamPendingEvents();
+        prefetched->updateDecimation();
+        prefetched->updateDownsampling();
+        prefetched->updatePixelPrefix();
+        prefetched->updateCompression();
+    }
+
+    return changed;
+}
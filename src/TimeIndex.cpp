@@ -0,0 +1,202 @@
+#include "TimeIndex.h"
+#include "EventCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <dv-processing/io/read_only_file.hpp>
+#include <omp.h>
+
+namespace fs = std::filesystem;
+
+std::string TimeIndex::indexPathFor(const std::string &recording) {
+    return recording + ".novaindex";
+}
+
+void TimeIndex::clear() {
+    sourceChecksum = 0;
+    eventCount = 0;
+    earliestTimestamp = 0;
+    latestTimestamp = 0;
+    std::vector<Entry>().swap(entries);
+}
+
+bool TimeIndex::open(const std::string &recording) {
+    clear();
+
+    std::FILE *file = std::fopen(indexPathFor(recording).c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+
+    TimeIndexHeader header{};
+    bool valid = std::fread(&header, sizeof(header), 1, file) == 1
+        && std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0
+        && header.version == VERSION
+        && header.intervalUs == INTERVAL_US
+        && header.entryCount > 0;
+    if (valid) {
+        entries.resize(static_cast<size_t>(header.entryCount));
+        valid = std::fread(entries.data(), sizeof(Entry), entries.size(), file) == entries.size()
+            && std::fgetc(file) == EOF;
+    }
+    std::fclose(file);
+
+    // Checked last, it reads from the recording
+    valid = valid && header.sourceChecksum == EventCache::sourceChecksum(recording);
+    if (!valid) {
+        clear();
+        return false;
+    }
+
+    sourceChecksum = header.sourceChecksum;
+    eventCount = header.eventCount;
+    earliestTimestamp = header.earliestTimestamp;
+    latestTimestamp = header.latestTimestamp;
+    return true;
+}
+
+bool TimeIndex::build(const std::string &recording, const std::atomic<bool> &cancel) {
+    clear();
+
+    std::vector<dv::FileDataDefinition> packets;
+    {
+        dv::io::ReadOnlyFile file(recording);
+        const auto &info = file.getFileInfo();
+        earliestTimestamp = info.mTimeLowest;
+        latestTimestamp = info.mTimeHighest;
+
+        for (const auto &stream : info.mStreams) {
+            if (stream.mName != "events") {
+                continue;
+            }
+
+            auto table = info.mPerStreamDataTables.find(stream.mId);
+            if (table != info.mPerStreamDataTables.end()) {
+                packets = table->second.Table;
+            }
+            break;
+        }
+    }
+    std::sort(packets.begin(), packets.end(), [](const dv::FileDataDefinition &a, const dv::FileDataDefinition &b) {
+        return a.TimestampStart < b.TimestampStart;
+    });
+
+    /*
+        A new entry starts at the first packet INTERVAL_US past the previous entry, unless the packet before it ends on
+        the very timestamp it starts with; events before an entry then always belong to earlier packets. Counts stay
+        -1 where a packet does not know its number of events.
+    */
+    std::vector<int64_t> counts;
+    for (size_t k = 0; k < packets.size(); k++) {
+        const dv::FileDataDefinition &packet = packets[k];
+        bool boundary = entries.empty() || (packet.TimestampStart >= entries.back().timestamp + INTERVAL_US
+            && packets[k - 1].TimestampEnd < packet.TimestampStart);
+        if (boundary) {
+            entries.push_back({ packet.TimestampStart, 0, packet.ByteOffset });
+            counts.push_back(0);
+        }
+        if (counts.back() >= 0) {
+            counts.back() = packet.NumElements >= 0 ? counts.back() + packet.NumElements : -1;
+        }
+    }
+
+    // No table at all, fall back to fixed intervals that are all counted by decoding
+    if (packets.empty()) {
+        for (int64_t t = earliestTimestamp; t <= latestTimestamp; t += INTERVAL_US) {
+            entries.push_back({ t, 0, -1 });
+            counts.push_back(-1);
+        }
+    }
+
+    // Unknown counts are decoded, every thread owning a reader of its own like EventData::streamWorker
+    const int numThreads = omp_get_max_threads();
+    const int numEntries = static_cast<int>(entries.size());
+    std::vector<std::unique_ptr<dv::io::MonoCameraRecording>> readers(numThreads);
+
+    #pragma omp parallel for schedule(dynamic, 16) num_threads(numThreads)
+    for (int k = 0; k < numEntries; k++) {
+        if (counts[k] >= 0 || cancel) {
+            continue;
+        }
+
+        auto &reader = readers[omp_get_thread_num()];
+        if (!reader) {
+            reader = std::make_unique<dv::io::MonoCameraRecording>(recording);
+        }
+        int64_t end = k + 1 < numEntries ? entries[k + 1].timestamp : latestTimestamp + 1;
+        auto events = reader->getEventsTimeRange(entries[k].timestamp, end);
+        counts[k] = events.has_value() ? static_cast<int64_t>(events->size()) : 0;
+    }
+
+    if (cancel || entries.empty()) {
+        clear();
+        return false;
+    }
+
+    for (size_t k = 0; k < entries.size(); k++) {
+        entries[k].firstEvent = eventCount;
+        eventCount += static_cast<uint64_t>(counts[k]);
+    }
+    sourceChecksum = EventCache::sourceChecksum(recording);
+
+    write(recording);
+
+    printf("Indexed %llu events of %s in %zu intervals\n", static_cast<unsigned long long>(eventCount),
+        recording.c_str(), entries.size());
+    return true;
+}
+
+void TimeIndex::write(const std::string &recording) const {
+    TimeIndexHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.intervalUs = INTERVAL_US;
+    header.sourceChecksum = sourceChecksum;
+    header.entryCount = entries.size();
+    header.eventCount = eventCount;
+    header.earliestTimestamp = earliestTimestamp;
+    header.latestTimestamp = latestTimestamp;
+
+    // Same as the event cache: a partial index must never look valid
+    const std::string finalPath = indexPathFor(recording);
+    const std::string tmpPath = finalPath + ".tmp";
+    std::FILE *file = std::fopen(tmpPath.c_str(), "wb");
+    if (!file) {
+        return;
+    }
+
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1
+        && std::fwrite(entries.data(), sizeof(Entry), entries.size(), file) == entries.size();
+    ok = (std::fclose(file) == 0) && ok;
+
+    std::error_code ec;
+    if (ok) {
+        fs::rename(tmpPath, finalPath, ec);
+    }
+    if (!ok || ec) {
+        fs::remove(tmpPath, ec);
+    }
+}
+
+const TimeIndex::Entry *TimeIndex::locate(int64_t timestamp) const {
+    auto it = std::upper_bound(entries.begin(), entries.end(), timestamp, [](int64_t t, const Entry &entry) {
+        return t < entry.timestamp;
+    });
+    return it == entries.begin() ? nullptr : &*(it - 1);
+}
+
+uint64_t TimeIndex::countBefore(int64_t timestamp, dv::io::MonoCameraRecording &reader) const {
+    const Entry *entry = locate(timestamp);
+    if (entry == nullptr) {
+        return 0;
+    }
+    if (entry->timestamp == timestamp) {
+        return entry->firstEvent;
+    }
+
+    auto events = reader.getEventsTimeRange(entry->timestamp, timestamp);
+    return entry->firstEvent + (events.has_value() ? events->size() : 0);
+}
@@ -0,0 +1,103 @@
+#include "VoxelGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <omp.h>
+
+using std::vector;
+
+static inline int64_t layerOf(const EventColumnsView &events, long long i, int64_t cellUs) {
+    return events.getTimestamp(i) / cellUs;
+}
+
+void VoxelGrid::build(const EventColumnsView &events, glm::vec2 cameraResolution, const VoxelGridOptions &options) {
+    clear();
+    if (events.empty()) {
+        return;
+    }
+
+    const int cellXY = std::max(1, options.cellXY);
+    const uint32_t cap = static_cast<uint32_t>(std::max(1, options.cap));
+    const int64_t cellUs = std::max<int64_t>(std::llround(options.cell_ms * 1000.0), 1);
+    const int gridW = static_cast<int>(cameraResolution.x) / cellXY + 1;
+    const int gridH = static_cast<int>(cameraResolution.y) / cellXY + 1;
+    const long long n = static_cast<long long>(events.size());
+
+    /*
+        Events are time sorted, so every t layer of the grid is a contiguous run. Chunks of roughly equal size are cut at
+        layer boundaries and processed independently, each thread reusing a single x / y counter grid for all its layers.
+    */
+    const int numChunks = std::max(1, omp_get_max_threads() * 4);
+    vector<long long> chunkStart(numChunks + 1, n);
+    chunkStart[0] = 0;
+    for (int c = 1; c < numChunks; c++) {
+        long long i = std::max(chunkStart[c - 1], n * c / numChunks);
+        while (i > 0 && i < n && layerOf(events, i - 1, cellUs) == layerOf(events, i, cellUs)) {
+            i++;
+        }
+        chunkStart[c] = i;
+    }
+
+    vector<EventColumns> chunkParticles(numChunks);
+    vector<vector<float>> chunkWeights(numChunks);
+
+    #pragma omp parallel
+    {
+        vector<uint32_t> counts(static_cast<size_t>(gridW) * gridH, 0);
+        vector<long long> kept;
+
+        #pragma omp for schedule(dynamic, 1)
+        for (int c = 0; c < numChunks; c++) {
+            auto cellOf = [&](long long i) {
+                int cx = std::min(events.x[i] / cellXY, gridW - 1);
+                int cy = std::min(events.y[i] / cellXY, gridH - 1);
+                return static_cast<size_t>(cy) * gridW + cx;
+            };
+
+            long long a = chunkStart[c];
+            while (a < chunkStart[c + 1]) {
+                // [a, b) is one t layer
+                int64_t layer = layerOf(events, a, cellUs);
+                long long b = a;
+                kept.clear();
+                while (b < chunkStart[c + 1] && layerOf(events, b, cellUs) == layer) {
+                    if (counts[cellOf(b)]++ < cap) {
+                        kept.push_back(b);
+                    }
+                    b++;
+                }
+
+                for (long long i : kept) {
+                    uint32_t count = counts[cellOf(i)];
+                    chunkParticles[c].push_back(events.x[i], events.y[i], events.getTimestamp(i), events.getPolarity(i) != 0.0f);
+                    chunkWeights[c].push_back(static_cast<float>(count) / static_cast<float>(std::min(count, cap)));
+                }
+
+                for (long long i = a; i < b; i++) {
+                    counts[cellOf(i)] = 0;
+                }
+                a = b;
+            }
+        }
+    }
+
+    // Stitch chunks back in time order; the reduced set is small, a sequential append is fine
+    for (int c = 0; c < numChunks; c++) {
+        particles.append(chunkParticles[c]);
+        weights.insert(weights.end(), chunkWeights[c].begin(), chunkWeights[c].end());
+    }
+
+    printf("Voxel grid kept %zu of %zu particles\n", particles.size(), events.size());
+}
+
+void VoxelGrid::clear() {
+    particles.clear();
+    weights.clear();
+}
+
+std::pair<int, int> VoxelGrid::getRange(int64_t ts_L, int64_t ts_R) const {
+    EventColumnsView view = particles.view();
+    return { static_cast<int>(view.lowerBound(ts_L)), static_cast<int>(view.upperBound(ts_R)) - 1 };
+}
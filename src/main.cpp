@@ -3,6 +3,7 @@
 #include <dv-processing/core/core.hpp>
 #include <dv-processing/core/utils.hpp>
 #include <dv-processing/io/mono_camera_recording.hpp>
+#include <dv-processing/io/network_writer.hpp>
 #include <dv-processing/core/frame.hpp>
 
 using namespace std;
@@ -41,21 +42,21 @@ FILE *ffmpeg;
 vector<unsigned char> pixels;
 
 Mesh g_meshSphere;
-Program g_progBasic, g_progInst, g_progFrame;
+Program g_progBasic, g_progInst, g_progFrame, g_progFrameImage;
 
 glm::vec3 g_lightPos, g_lightCol;
 BPMaterial g_lightMat;
 
 // TODO: Maybe we want unique_ptr
 shared_ptr<EventData> g_eventData;
+Session g_session; // recordings of the opened file or playlist, g_eventData is its current one
 
 float g_particleScale(0.75f);
 
 static void updateEvtDataAndCamera() {
-    // Load .aedat events into EventData object //
-    g_eventData = make_shared<EventData>();
-    g_eventData->initParticlesFromFile(g_dataFilepath);
-    g_eventData->initInstancing(g_progInst);
+    // Load .aedat events into EventData object in the background, streamEvtData() picks up the batches //
+    g_session.open(g_dataFilepath);
+    g_eventData = g_session.current();
 
     // Camera //
     g_camera = Camera();
@@ -65,11 +66,49 @@ static void updateEvtDataAndCamera() {
     loadFile = false;
 }
 
+static void streamEvtData() {
+    // Playlist: switch to a recording picked in the Load panel, prefetch the one after the current
+    if (g_session.update()) {
+        g_eventData = g_session.current();
+        g_camera.setEvtCenter(g_eventData->getCenter());
+        g_frameSceneFBO.setDirtyBit(true);
+    }
+
+    // Append whatever the loader thread decoded since last frame so the 3D view and DCE frame fill in progressively
+    if (g_eventData->streamPendingEvents()) {
+        g_camera.setEvtCenter(g_eventData->getCenter());
+        g_frameSceneFBO.setDirtyBit(true);
+    }
+
+    // Live mode: newest events from the network stream, the windows slide along with them
+    if (g_eventData->updateLiveWindow()) {
+        g_camera.setEvtCenter(g_eventData->getCenter());
+        g_frameSceneFBO.setDirtyBit(true);
+    }
+
+    // Event Frequency slider: decimate again from the full resolution events instead of reloading
+    if (g_eventData->updateDecimation()) {
+        g_frameSceneFBO.setDirtyBit(true);
+    }
+
+    if (g_eventData->updateDownsampling()) {
+        g_frameSceneFBO.setDirtyBit(true);
+    }
+
+    if (g_eventData->updatePixelPrefix()) {
+        g_frameSceneFBO.setDirtyBit(true);
+    }
+
+    if (g_eventData->updateCompression()) {
+        g_frameSceneFBO.setDirtyBit(true);
+    }
+}
+
 static void initEvtDataAndCamera() {
     // Load .aedat events into EventData object //
     g_eventData = make_shared<EventData>();
     g_eventData->initParticlesEmpty();
-    g_eventData->initInstancing(g_progInst);
+    g_eventData->initInstancing();
 
     // Camera //
     g_camera = Camera();
@@ -79,6 +118,31 @@ static void initEvtDataAndCamera() {
     loadFile = false;
 }
 
+/*
+    Auto-update playback of a playlist: once the next step would run past the end of the current recording, the windows
+    continue in the next one, which the session has already loaded in the background.
+*/
+static bool reachedRecordingEnd() {
+    if (g_frameSceneFBO.getAutoUpdate() == FrameViewportFBO::EVENT_AUTO_UPDATE) {
+        return static_cast<uint64_t>(g_eventData->getEventWindow_R()) + g_frameSceneFBO.getFramePeriod_E() >= g_eventData->getMaxEvent();
+    }
+    return g_eventData->getTimeWindow_R() + g_frameSceneFBO.getFramePeriod_T() > g_eventData->getMaxTimestamp();
+}
+
+static void continueInNextRecording() {
+    shared_ptr<EventData> previous = g_eventData;
+    g_session.select(g_session.getCurrentIndex() + 1);
+    g_session.update();
+    g_eventData = g_session.current();
+
+    bool byEvents = g_frameSceneFBO.getAutoUpdate() == FrameViewportFBO::EVENT_AUTO_UPDATE;
+    g_eventData->continueFrom(*previous, byEvents, g_frameSceneFBO.getFramePeriod_T(), g_frameSceneFBO.getFramePeriod_E());
+
+    // The time step is normalized per recording as well
+    g_frameSceneFBO.getFramePeriod_T() *= g_eventData->getDiffScale() / previous->getDiffScale();
+    g_camera.setEvtCenter(g_eventData->getCenter());
+}
+
 static void init() {
     srand(0);
 
@@ -112,6 +176,7 @@ static void init() {
         g_progBasic = genPhongProg(g_resourceDir);
         g_progInst = genInstProg(g_resourceDir);
         g_progFrame = genBasicProg(g_resourceDir); 
+        g_progFrameImage = genFrameImageProg(g_resourceDir);
 
     // Initialize data + camera and set its center //
         initEvtDataAndCamera();
@@ -185,7 +250,13 @@ static void render() {
     // don't have many more
     float nextUpdateTime = t - 1 / g_frameSceneFBO.getUpdateFPS();
     if (g_frameSceneFBO.getAutoUpdate() != FrameViewportFBO::MANUAL_UPDATE && nextUpdateTime >= g_frameSceneFBO.getLastRenderTime()) {
-        if (g_frameSceneFBO.getAutoUpdate() == FrameViewportFBO::EVENT_AUTO_UPDATE) {
+        if (g_session.hasNext() && reachedRecordingEnd()) {
+            // Waits at the end rather than stopping while the next recording is still loading
+            if (g_session.isNextReady()) {
+                continueInNextRecording();
+            }
+        }
+        else if (g_frameSceneFBO.getAutoUpdate() == FrameViewportFBO::EVENT_AUTO_UPDATE) {
             uint framePeriod = g_frameSceneFBO.getFramePeriod_E();
             uint frameStart = g_eventData->getEventWindow_L();
             uint frameEnd = g_eventData->getEventWindow_R();
@@ -231,8 +302,9 @@ static void render() {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); 
 
         glm::vec2 viewport_resolution(g_frameSceneFBO.getFBOwidth(), g_frameSceneFBO.getFBOheight());
-        g_eventData->drawFrame(g_progFrame, viewport_resolution, 
-            g_frameSceneFBO.isMorlet(), g_frameSceneFBO.getFreq(), g_frameSceneFBO.getPCA()); 
+        g_eventData->drawFrame(g_progFrame, g_progFrameImage, viewport_resolution, 
+            g_frameSceneFBO.isMorlet(), g_frameSceneFBO.getFreq(), g_frameSceneFBO.getPCA(),
+            g_frameSceneFBO.getAccumulationImage()); 
                 
         g_frameSceneFBO.unbind();
         g_frameSceneFBO.setDirtyBit(false);
@@ -244,7 +316,7 @@ static void render() {
         ImGui::NewFrame();
         
         drawGUI(g_camera, g_fps, g_particleScale, g_isMainviewportHovered, g_mainSceneFBO, 
-            g_frameSceneFBO, g_eventData, g_dataFilepath, video_name, recording, g_dataDir, loadFile);
+            g_frameSceneFBO, g_eventData, g_session, g_dataFilepath, video_name, recording, g_dataDir, loadFile);
     
     // Render ImGui //
         ImGui::Render();
@@ -292,10 +364,47 @@ static void video_output() {
 
 }
 
+/*
+    Serves a recording as a dv-processing network event stream at its original pace, so live mode can be tried without a
+    camera: run `NOVA --replay <file> <port>` next to NOVA and connect to 127.0.0.1:<port> from the Load panel.
+*/
+static int replay(const string &filepath, int port) {
+    dv::io::MonoCameraRecording reader(filepath);
+    if (!reader.isEventStreamAvailable() || !reader.getEventResolution().has_value()) {
+        cerr << filepath << " has no event stream" << endl;
+        return -1;
+    }
+
+    dv::io::NetworkWriter writer("127.0.0.1", static_cast<uint16_t>(port),
+        dv::io::Stream::EventStream(0, "events", "NOVA replay", reader.getEventResolution().value()));
+    cout << "Replaying " << filepath << " on 127.0.0.1:" << port << endl;
+
+    auto start = chrono::steady_clock::now();
+    int64_t firstTimestamp = -1;
+    while (reader.isRunning()) {
+        std::optional<dv::EventStore> events = reader.getNextEventBatch();
+        if (!events.has_value() || events->isEmpty()) {
+            continue;
+        }
+        if (firstTimestamp < 0) {
+            firstTimestamp = events->getLowestTime();
+        }
+
+        this_thread::sleep_until(start + chrono::microseconds(events->getHighestTime() - firstTimestamp));
+        writer.writeEvents(*events);
+    }
+    return 0;
+}
+
 int main(int argc, char** argv) {
+    if (argc == 4 && string(argv[1]) == "--replay") {
+        return replay(argv[2], atoi(argv[3]));
+    }
+
     // resources/ data/ 
     if (argc < 3) {
         cout << "Usage: ./NOVA <resource_dir> <data_dir>" << endl;
+        cout << "       ./NOVA --replay <file.aedat4> <port>" << endl;
         return 0;
     }
 
@@ -353,6 +462,7 @@ int main(int argc, char** argv) {
 
     string curFilepath = g_dataFilepath;
     while (!glfwWindowShouldClose(g_window)) {
+        streamEvtData();
         render();
         
         if (loadFile) {
@@ -20,6 +20,7 @@
 #include <Windows.h>
 #include <shobjidl.h>
 #include <fstream>
+#include <filesystem>
 
 using std::cout, std::endl, std::cerr;
 using std::shared_ptr, std::make_shared;
@@ -72,9 +73,11 @@ string OpenFileDialog(string& initialDirectory) {
     
     //Sets file filter
     const COMDLG_FILTERSPEC fileTypes[] = {
-        {L"AEDAT4 Files", L"*.aedat4"}
+        {L"AEDAT4 Files", L"*.aedat4"},
+        {L"Playlists", L"*.m3u"},
+        {L"Raw EVT / CSV Files", L"*.raw;*.csv;*.txt"}
     };
-    hr = pFileOpen->SetFileTypes(1, fileTypes);
+    hr = pFileOpen->SetFileTypes(3, fileTypes);
     hr = pFileOpen->SetTitle(L"Select a data AEDAT4 File");
 
     // Set the initial directory
@@ -116,9 +119,10 @@ bool isValidFilePath(string filePath) {
         return false;
     }
 
-    // Check if the file extension is ".aedat4"
+    // Check if the file extension is ".aedat4", ".m3u" for a playlist of them, or one EventImporter reads
     size_t extensionPos = filePath.find_last_of('.');
-    if (extensionPos == string::npos || filePath.substr(extensionPos) != ".aedat4") {
+    if (extensionPos == string::npos || (filePath.substr(extensionPos) != ".aedat4" && !Session::isPlaylist(filePath)
+        && !EventImporter::canImport(filePath))) {
         return false;
     }
 
@@ -162,6 +166,9 @@ Program genInstProg(const std::string &resource_dir) {
     prog.addUniform("MV_it");
     
     prog.addUniform("particleScale");
+    prog.addUniform("timeOrigin");
+    prog.addUniform("timeScale");
+    prog.addUniform("instanceBase");
 
     prog.addUniform("negColor");
     prog.addUniform("posColor");
@@ -169,7 +176,10 @@ Program genInstProg(const std::string &resource_dir) {
     prog.addAttribute("aPos");
     prog.addAttribute("aNor");
     prog.addAttribute("aTex");
-    prog.addAttribute("aInstPos"); // We additionally require a position matrix per vertex for instancing
+    // Per instance event columns, see EventBuffers.h; polarity comes from a storage buffer
+    prog.addAttribute("aInstX");
+    prog.addAttribute("aInstY");
+    prog.addAttribute("aInstDt");
 
     return prog;
 }
@@ -188,6 +198,19 @@ Program genBasicProg(const string &resource_dir) {
     return prog;
 }
 
+Program genFrameImageProg(const string &resource_dir) {
+    Program prog = Program();
+    prog.setShaderNames(resource_dir + "frame_image.vsh", resource_dir + "frame_image.fsh");
+    prog.setVerbose(true);
+    prog.init();
+
+    prog.addAttribute("corner");
+    prog.addUniform("projection");
+    prog.addUniform("image");
+
+    return prog;
+}
+
 void sendToPhongShader(const Program& prog, const MatrixStack& P, const MatrixStack& MV, const vec3& lightPos, const vec3& lightCol, const BPMaterial& mat) {
     glUniformMatrix4fv(prog.getUniform("P"), 1, GL_FALSE, glm::value_ptr(P.topMatrix()));
     glUniformMatrix4fv(prog.getUniform("MV"), 1, GL_FALSE, glm::value_ptr(MV.topMatrix()));
@@ -534,8 +557,8 @@ static void spaceWindowWrapper(bool &dSpaceWindow, shared_ptr<EventData> &evtDat
 }
 
 void drawGUI(const Camera& camera, float fps, float &particle_scale, bool &is_mainViewportHovered,
-    BaseViewportFBO &mainSceneFBO, FrameViewportFBO &frameSceneFBO, shared_ptr<EventData> &evtData, std::string& datafilepath,
-    std::string &video_name, bool &recording, std::string& datadirectory, bool &loadFile) {
+    BaseViewportFBO &mainSceneFBO, FrameViewportFBO &frameSceneFBO, shared_ptr<EventData> &evtData, Session &session,
+    std::string& datafilepath, std::string &video_name, bool &recording, std::string& datadirectory, bool &loadFile) {
 
     drawGUIDockspace();
 
@@ -584,10 +607,133 @@ void drawGUI(const Camera& camera, float fps, float &particle_scale, bool &is_ma
                 datafilepath=std::move(newFilePath);
             }
         }
-        ImGui::Text("Event Frequency");    
-        ImGui::SliderInt("##modFreq", (int *) &EventData::modFreq, 1, 1000);
-        EventData::modFreq = std::max((uint) 1, EventData::modFreq);
+        if (evtData->isLoading()) {
+            char progressLabel[32];
+            snprintf(progressLabel, sizeof(progressLabel), "Loading %.0f%%", 100.0f * evtData->getLoadProgress());
+            ImGui::ProgressBar(evtData->getLoadProgress(), ImVec2(-1.0f, 0.0f), progressLabel);
+            if (ImGui::Button("Cancel Load")) {
+                evtData->cancelLoading();
+            }
+        }
 
+        // Playlist of consecutive recordings, the next one is prefetched in the background, see Session.h
+        if (session.size() > 1) {
+            size_t current = session.getCurrentIndex();
+            ImGui::Text("Recording %zu / %zu: %s", current + 1, session.size(),
+                std::filesystem::path(session.getRecording(current)).filename().string().c_str());
+            if (current > 0 && ImGui::Button("Previous Recording")) {
+                session.select(current - 1);
+            }
+            if (session.hasNext()) {
+                if (current > 0) {
+                    ImGui::SameLine();
+                }
+                if (ImGui::Button("Next Recording")) {
+                    session.select(current + 1);
+                }
+                ImGui::SameLine();
+                if (session.isNextReady()) {
+                    ImGui::Text("Next ready");
+                }
+                else {
+                    ImGui::Text("Prefetching next %.0f%%", 100.0f * session.getNextProgress());
+                }
+            }
+        }
+
+        // Live network stream instead of a file, e.g. from DV or `NOVA --replay <file> <port>`
+        static char liveHost[64] = "127.0.0.1";
+        static int livePort = 7777;
+        ImGui::Text("Live:");
+        ImGui::InputText("Host", liveHost, sizeof(liveHost));
+        ImGui::InputInt("Port", &livePort);
+        livePort = std::clamp(livePort, 1, 65535);
+        ImGui::SliderFloat("Live Window (ms)", &EventData::liveWindow_ms, 1.0f, 10000.0f, "%.0f");
+        if (!evtData->isLive()) {
+            if (ImGui::Button("Connect")) {
+                evtData->startLiveStream(liveHost, livePort);
+            }
+        }
+        else {
+            if (evtData->isLiveConnected() && ImGui::Button("Disconnect")) {
+                evtData->stopLiveStream();
+            }
+            ImGui::SameLine();
+            ImGui::Text(evtData->isLiveConnected() ? "Streaming" : "Disconnected");
+        }
+        ImGui::Separator();
+
+        ImGui::Checkbox("Use Event Cache", &EventData::useEventCache);
+        if (EventData::useEventCache) {
+            // Larger recordings are paged from the cache instead of kept in memory
+            ImGui::InputInt("Resident Budget (MB)", &EventData::residentBudget_MB, 256, 1024);
+            EventData::residentBudget_MB = std::max(EventData::residentBudget_MB, 64);
+        }
+        if (evtData->isPaged()) {
+            ImGui::Text("Paging %u events from disk", evtData->getMaxEvent());
+        }
+
+        // Applied to the loaded events once they are complete, see CompressedEventStore.h
+        ImGui::Checkbox("Compress Events in RAM", &EventData::compressResident);
+        if (evtData->isCompressed()) {
+            ImGui::Text("%.1f MB, %.2f bytes per event", evtData->getCompressedBytes() / 1048576.0,
+                static_cast<double>(evtData->getCompressedBytes()) / evtData->getMaxEvent());
+        }
+
+        LoadOptions &loadOptions = EventData::loadOptions;
+        ImGui::Combo("Decimation", &loadOptions.decimationType, "Events\0Packets\0Time\0");
+        if (loadOptions.decimationType == LoadOptions::DECIMATE_EVENTS) {
+            ImGui::Text("Event Frequency");    
+            ImGui::SliderInt("##modFreq", (int *) &loadOptions.modFreq, 1, 1000);
+        }
+        else if (loadOptions.decimationType == LoadOptions::DECIMATE_PACKETS) {
+            ImGui::Text("Keep 1 of every N packets");
+            ImGui::SliderInt("##packetStride", (int *) &loadOptions.packetStride, 1, 1000);
+        }
+        else if (loadOptions.decimationType == LoadOptions::DECIMATE_TIME) {
+            ImGui::SliderFloat("Keep (ms)", &loadOptions.keep_ms, 0.1f, 1000.0f, "%.1f");
+            ImGui::SliderFloat("Of every (ms)", &loadOptions.period_ms, 0.1f, 10000.0f, "%.1f");
+        }
+        loadOptions.modFreq = std::max((uint32_t) 1, loadOptions.modFreq);
+        loadOptions.packetStride = std::max((uint32_t) 1, loadOptions.packetStride);
+        loadOptions.keep_ms = std::max(loadOptions.keep_ms, 0.001f);
+        loadOptions.period_ms = std::max(loadOptions.period_ms, loadOptions.keep_ms);
+
+        // Tested per event while decoding, so events outside are never stored
+        ImGui::Checkbox("Region of Interest", &loadOptions.roiEnabled);
+        if (loadOptions.roiEnabled) {
+            ImGui::InputInt2("Min X / Y", &loadOptions.roiMinX);
+            ImGui::InputInt2("Max X / Y", &loadOptions.roiMaxX);
+        }
+        ImGui::Combo("Load Polarity", &loadOptions.polarity, "All\0Positive\0Negative\0");
+        loadOptions.roiMinX = std::clamp(loadOptions.roiMinX, 0, 65535);
+        loadOptions.roiMinY = std::clamp(loadOptions.roiMinY, 0, 65535);
+        loadOptions.roiMaxX = std::clamp(loadOptions.roiMaxX, loadOptions.roiMinX, 65535);
+        loadOptions.roiMaxY = std::clamp(loadOptions.roiMaxY, loadOptions.roiMinY, 65535);
+
+        // Only this slice of the recording is decoded, see TimeIndex.h; To <= From loads everything
+        ImGui::Text("Time Range (s)");
+        ImGui::InputFloat("From (s)", &loadOptions.rangeStart_s, 1.0f, 60.0f, "%.3f");
+        ImGui::InputFloat("To (s)", &loadOptions.rangeEnd_s, 1.0f, 60.0f, "%.3f");
+        loadOptions.rangeStart_s = std::max(loadOptions.rangeStart_s, 0.0f);
+        loadOptions.rangeEnd_s = std::max(loadOptions.rangeEnd_s, 0.0f);
+        if (!datafilepath.empty() && ImGui::Button("Reload File")) {
+            dFile = true;
+            loadFile = true;
+        }
+        ImGui::Separator();
+
+        // Applied to the loaded events without reloading, see VoxelGrid.h
+        VoxelGridOptions &voxelOptions = EventData::voxelOptions;
+        ImGui::Checkbox("Voxel Grid Downsampling", &voxelOptions.enabled);
+        if (voxelOptions.enabled) {
+            ImGui::SliderInt("Voxel Size (px)", &voxelOptions.cellXY, 1, 64);
+            ImGui::SliderFloat("Voxel Depth (ms)", &voxelOptions.cell_ms, 0.01f, 100.0f, "%.2f");
+            ImGui::SliderInt("Events per Voxel", &voxelOptions.cap, 1, 64);
+        }
+        voxelOptions.cellXY = std::max(1, voxelOptions.cellXY);
+        voxelOptions.cell_ms = std::max(voxelOptions.cell_ms, 0.001f);
+        voxelOptions.cap = std::max(1, voxelOptions.cap);
 
         // TODO: Cache recent files and state?
     ImGui::End();
@@ -698,6 +844,16 @@ void drawGUI(const Camera& camera, float fps, float &particle_scale, bool &is_ma
         dProcessingOptions |= ImGui::SliderFloat("Frequency (Hz)", &frameSceneFBO.getFreq(), 0.001f, 250); // TODO decide reasonable range
         dProcessingOptions |= ImGui::SliderFloat(unitLabels[FWHM].c_str(), &MorletFunc::h, 0.0001f, (evtData->getTimeWindow_R() - evtData->getTimeWindow_L()) * 0.5, "%.4f");
         dProcessingOptions |= ImGui::Checkbox("Morlet Shutter", &frameSceneFBO.isMorlet());
+        dProcessingOptions |= ImGui::Checkbox("Accumulation Image", &frameSceneFBO.getAccumulationImage());
+        if (frameSceneFBO.getAccumulationImage()) {
+            // Box shutter only, the prefix sums are rebuilt by updatePixelPrefix() which redraws the frame again
+            dProcessingOptions |= ImGui::Checkbox("Prefix Sum Frames", &EventData::usePixelPrefix);
+            dProcessingOptions |= ImGui::Checkbox("Incremental Frames", &EventData::incrementalFrames);
+            if (EventData::usePixelPrefix) {
+                ImGui::InputInt("Prefix Budget (MB)", &EventData::pixelPrefixBudget_MB, 64, 256);
+                EventData::pixelPrefixBudget_MB = std::max(EventData::pixelPrefixBudget_MB, 16);
+            }
+        }
         dProcessingOptions |= ImGui::Checkbox("PCA", &frameSceneFBO.getPCA());
         dProcessingOptions |= ImGui::Checkbox("Positive Events Only", &evtData->getIsPositiveOnly());
         frameSceneFBO.getFreq() = std::max(frameSceneFBO.getFreq(), 0.01f);
@@ -713,6 +869,24 @@ void drawGUI(const Camera& camera, float fps, float &particle_scale, bool &is_ma
         if (ImGui::Button("Stop Record")) {
             recording = false;
         }
+        ImGui::Separator();
+
+        // Writes the events selected by the windows above next to the recording, see EventExporter.h
+        static int exportFormat = EventExporter::FORMAT_NPY;
+        static string exportStatus;
+        ImGui::Text("Export options");
+        ImGui::Combo("Export Format", &exportFormat, "Binary (.bin)\0NumPy (.npy)\0AEDAT4 (.aedat4)\0");
+        if (evtData->getMaxEvent() > 0 && !evtData->isLoading() && ImGui::Button("Export Selection")) {
+            auto format = static_cast<EventExporter::Format>(exportFormat);
+            std::filesystem::path exportPath = evtData->isLive() || evtData->getFilename().empty()
+                ? std::filesystem::path(datadirectory) / "live" : std::filesystem::path(evtData->getFilename());
+            exportPath.replace_filename(exportPath.stem().string() + "_selection" + EventExporter::extensionOf(format));
+            exportStatus = evtData->exportSelection(exportPath.string(), format)
+                ? "Wrote " + exportPath.filename().string() : "Export failed, see console";
+        }
+        if (!exportStatus.empty()) {
+            ImGui::Text("%s", exportStatus.c_str());
+        }
 
     ImGui::End();
 
@@ -0,0 +1,89 @@
+/*
+    Checks every Morlet kernel this machine runs against the portable one, and the portable one against the exact
+    wavelet, within the tolerance documented in ContributionFunc.h. Exits nonzero on the first failure.
+*/
+
+#include "ContributionFunc.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+static const char *kernelName(MorletShutter::Kernel kernel) {
+    switch (kernel) {
+        case MorletShutter::Kernel::Avx2:
+            return "AVX2";
+        case MorletShutter::Kernel::Avx512:
+            return "AVX-512";
+        default:
+            return "portable";
+    }
+}
+
+static float tolerance(float f, float t) {
+    return 1e-6f * 4.0f * BaseFunc::contribution * std::max(1.0f, std::fabs(f * t));
+}
+
+// The formula of ContributionFunc.h for float inputs, evaluated in double
+static float exactWeight(float f, float t, float polarity) {
+    const double pi = std::acos(-1.0);
+    const double h = MorletFunc::h;
+    const double weight = std::cos(2.0 * pi * f * t) * std::exp(-4.0 * std::log(2.0) * t * t / (h * h)) * polarity;
+    return static_cast<float>(weight * (weight < 0.0 ? 4.0 : 1.0) * BaseFunc::contribution);
+}
+
+int main() {
+    const MorletShutter::Kernel kernels[] = { MorletShutter::Kernel::Avx2, MorletShutter::Kernel::Avx512 };
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    int failures = 0;
+
+    for (MorletShutter::Kernel kernel : kernels) {
+        printf("%s kernel: %s\n", kernelName(kernel), MorletShutter::isSupported(kernel) ? "testing" : "not supported, skipped");
+    }
+
+    for (int trial = 0; trial < 200 && failures == 0; trial++) {
+        // Frequencies and widths across the GUI's ranges, times up to a few periods or envelope widths out, and odd
+        // batch sizes so the vector kernels run their tails
+        const float f = std::pow(10.0f, uniform(random) * 2.0f + 1.0f);
+        MorletFunc::h = std::pow(10.0f, uniform(random) * 2.0f - 1.0f);
+        BaseFunc::contribution = std::pow(10.0f, uniform(random) - 1.0f);
+        const float span = (trial % 2 == 0 ? 1.0f : 8.0f) * std::min(1.0f / f, 5.0f * MorletFunc::h);
+        const size_t n = 1000 + trial;
+
+        std::vector<float> t(n), polarity(n), expected(n), weights(n);
+        for (size_t i = 0; i < n; i++) {
+            t[i] = uniform(random) * span;
+            polarity[i] = (random() & 1) ? 1.0f : -1.0f;
+        }
+        MorletShutter(f, MorletShutter::Kernel::Portable).getWeights(t.data(), polarity.data(), n, expected.data());
+
+        for (size_t i = 0; i < n && failures == 0; i++) {
+            const float exact = exactWeight(f, t[i], polarity[i]);
+            if (!(std::fabs(expected[i] - exact) <= tolerance(f, t[i]))) {
+                printf("portable kernel: f = %g, h = %g, t = %g gives %g, exact %g\n", f, MorletFunc::h, t[i], expected[i], exact);
+                failures++;
+            }
+        }
+
+        for (MorletShutter::Kernel kernel : kernels) {
+            if (!MorletShutter::isSupported(kernel)) {
+                continue;
+            }
+            std::fill(weights.begin(), weights.end(), NAN);
+            MorletShutter(f, kernel).getWeights(t.data(), polarity.data(), n, weights.data());
+            for (size_t i = 0; i < n && failures == 0; i++) {
+                if (!(std::fabs(weights[i] - expected[i]) <= tolerance(f, t[i]))) {
+                    printf("%s kernel: f = %g, h = %g, t = %g gives %g, portable %g\n", kernelName(kernel), f,
+                        MorletFunc::h, t[i], weights[i], expected[i]);
+                    failures++;
+                }
+            }
+        }
+    }
+
+    printf(failures == 0 ? "All kernels within tolerance\n" : "Failed\n");
+    return failures == 0 ? 0 : 1;
+}